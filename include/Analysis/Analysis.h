@@ -20,43 +20,43 @@
 #include "llvm/Operator.h"
 
 #include "Analysis/AnalysisContext.h"
+#include "Analysis/DefUseIndex.h"
+#include "Analysis/ModRefSummary.h"
 
 namespace llvm {
 
-	enum ArgModRefResult {
-		NoModRef = 0x0,
-		Ref			 = 0x1,
-		Mod			 = 0x2,
-		ModRef 	 = 0x3
+	/// The scratch state of an analysis. Concurrent analyses use a cache each;
+	/// the analyses of one thread may share it.
+	struct AnalysisCache {
+		DefUseIndex defUse; // of the function analyzed last
 	};
 
 	class Analysis {
 
 	protected:
 		AnalysisContext *ctx_;
+		AnalysisCache *cache_;
 
-		/// check every dependence (read or write) of a given function to globals
-		void checkGlobalDependencies(Function *func);
+		/// collects the globals read and changed by any function the callsite
+		/// may call
+		void getGlobalsForCallSite(const CallSite&, BitVector &reads,
+															 BitVector &writes);
 
-	  /// check if the definition of a value reaches an instruction (recursively).
-	  bool checkDefUse(Value*, Instruction*, int, bool, bool);
+	  /// check if the definition of a value reaches a callsite of the parent
+	  /// function through a branch or, if viaValue is set, through its uses.
+	  bool checkDefUse(Function *parent, Value*, Instruction*, bool viaValue);
 
-	  /// check if the definition of a value is used within a branch (recursively).
-	  bool checkBranchDefUse(BranchInst*, Instruction*, int, int, bool);
-
-	  /// analyzes whether and how an argument is accessed by a function
+	  /// returns whether and how an argument is accessed by a function
 	  ArgModRefResult getModRefForArg(const Function*, Argument*) const;
 
-	  /// analyzes how the instruction accesses the given value
-	  ArgModRefResult getModRefForInst(Instruction *I, const Value *pArg) const;
-
-	  /// returns the mod/ref behavior of a callsite concerning a specific arg
-	  ArgModRefResult getModRefForDSNode(const CallSite&,
-																			 const DSNodeHandle&,
-																			 const DSGraph*) const;
+	  /// returns the mod/ref behavior of the callees of a callsite concerning
+	  /// the argument with the given number
+	  ArgModRefResult getModRefForCallArg(const AnalysisContext::CalleeVecTy&,
+																				unsigned argNo) const;
 
 	public:
-		Analysis(AnalysisContext *ctx): ctx_(ctx) { }
+		Analysis(AnalysisContext *ctx, AnalysisCache *cache)
+			: ctx_(ctx), cache_(cache) { }
 
 		// the analyze method is expected to be overwritten
 		virtual void analyze(Function*, Instruction*, Instruction*) = 0;
@@ -13,6 +13,11 @@
 
 #include "llvm/Instructions.h"
 #include "llvm/Analysis/CallGraph.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Mutex.h"
 
 #include "DynCallGraph/DynCallGraph.h"
 #include "Analysis/DGNodeSet.h"
@@ -37,14 +42,16 @@ namespace llvm {
 
 	// forward declaration
 	class ParPot;
+	class ModRefSummary;
+	class DominatorTree;
+	class PostDominatorTree;
 
+	/// The AnalysisContext is shared by the analyses of all threads; its
+	/// methods may be called concurrently once the dependence graphs exist.
 	class AnalysisContext {
 		AnalysisContext(const AnalysisContext&);            // DO NOT IMPLEMENT
 		AnalysisContext& operator=(const AnalysisContext*); // DO NOT IMPLEMENT
 
-		// members
-		FuncGlobalsMapTy fGlobs_;
-
 		// members
 		Module *pMod_;
 		DynCallGraph *pDCG_;
@@ -53,20 +60,97 @@ namespace llvm {
 
 		DGNodeSet::DepGraphMapTy fDepGraphs_;
 
+	public:
+		/// the functions called by a callsite with their share of the calls
+		typedef std::vector<std::pair<Function*, double> > CalleeVecTy;
+
+	private:
+		// functions that may be called indirectly, indexed by name
+		StringMap<Function*> calleeIndex_;
+
+		// resolved callsites; they depend on the dynamic call graph
+		mutable DenseMap<Instruction*, Function*> funcCache_;
+		mutable DenseMap<Instruction*, CalleeVecTy> calleeCache_;
+
+		// guards the resolved callsites and the DS graph locks
+		mutable sys::Mutex lock_;
+
+		// the DS graphs are shared by functions of an equivalence class
+		std::map<const DSGraph*, sys::Mutex*> dsgLocks_;
+
+		// the mod/ref summaries; they depend on the dynamic call graph
+		OwningPtr<ModRefSummary> modRef_;
+
+		// the dominator trees of the analyzed functions
+		std::map<const Function*, DominatorTree*> domTrees_;
+		std::map<const Function*, PostDominatorTree*> postDomTrees_;
+
+		/// builds the name index of the functions that may be called indirectly
+		void buildCalleeIndex(void);
+
+		/// returns the defined function with the given name that may be called
+		/// indirectly or null
+		Function* lookupCallee(StringRef name) const;
+
 	public:
 		AnalysisContext(Module *pMod, DynCallGraph *pDCG, CallGraph *pCG,
 								 EquivBUDataStructures *pDSA, BUDataStructures *pBU):
-									 pMod_(pMod), pDCG_(pDCG), pCG_(pCG), pDSA_(pDSA){ }
+									 pMod_(pMod), pDCG_(pDCG), pCG_(pCG), pDSA_(pDSA){
+			buildCalleeIndex();
+		}
+
+		~AnalysisContext();
 
 		/// returns a function pointer tied to the given callsite. If a dynamic
 		/// function is called, the pointer to the concrete function may be returned
 		/// if possible. Returns false if this isn't possible.
 		Function* getFunctionPtr(const CallSite&) const;
 
+		/// collects every function that may be called by the given callsite,
+		/// weighted by its share of the calls. A direct call has a single callee
+		/// of weight 1; an indirect call has the targets recorded by the dynamic
+		/// call graph. Returns false if no callee is known.
+		bool getCallees(const CallSite&, CalleeVecTy&) const;
+
+		/// collects the callees of the given callsite as recorded by the given
+		/// dynamic call graph; nothing is cached
+		bool getCallees(const CallSite&, CalleeVecTy&,
+		                const DynCallGraph&) const;
+
 		DGNodeSet::DepGraphMapTy* getDepGraphs(void) { return &fDepGraphs_; }
-		FuncGlobalsMapTy *getGlobals(void) { return &fGlobs_; }
+
+		/// computes the mod/ref summaries of all functions for the current
+		/// dynamic call graph; must be called before analyses run
+		void computeModRefSummary(void);
+
+		const ModRefSummary &getModRefSummary(void) const {
+			assert(modRef_ && "Mod/ref summaries haven't been computed!");
+			return *modRef_;
+		}
+
+		/// computes the dominator and post-dominator trees of a function unless
+		/// they exist; must be called before analyses of the function run
+		void computeDominators(Function &F);
+
+		/// returns the dominator tree of a function or null
+		DominatorTree* getDomTree(const Function &F) const;
+
+		/// returns the post-dominator tree of a function or null
+		PostDominatorTree* getPostDomTree(const Function &F) const;
+
+		/// returns the DS graph of a function along with the lock that has to
+		/// be held while analyses of several threads access it
+		DSGraph* getDSGraph(const Function &F, sys::Mutex *&lock);
 
 	  DynCallGraph* getDCG(void) const { return pDCG_; }
+	  void setDCG(DynCallGraph *pDCG) {
+	    if (pDCG == pDCG_) return;
+	    sys::ScopedLock guard(lock_);
+	    pDCG_ = pDCG;
+	    funcCache_.clear();
+	    calleeCache_.clear();
+	    modRef_.reset();
+	  }
 	  CallGraph* getGC(void) const { return pCG_; }
 	  EquivBUDataStructures* getDSA(void) const { return pDSA_; }
 	  Module* getMod(void) const { return pMod_; }
@@ -0,0 +1,104 @@
+//======== Analysis/ConflictMatrix.h - Call-site conflicts - Interface =======//
+//
+//                 ParPot - Parallelization Potential - Analysis
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the ConflictMatrix class, which finds the memory conflicts
+// of all pairs of call sites within a function.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef PARPOT_CONFLICTMATRIX_H_
+#define PARPOT_CONFLICTMATRIX_H_
+
+#include "Analysis/AnalysisContext.h"
+#include "Analysis/DepGraph.h"
+#include "Analysis/ModRefSummary.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+	/// The ConflictMatrix class collects the memory objects each call site of a
+	/// function reads and writes: the globals and the DS nodes of pointer
+	/// arguments, numbered in the order of their first access. The accesses
+	/// become rows of 64-bit words, and every pair of call sites is checked by
+	/// intersecting its rows word by word, so only actual conflicts cost more
+	/// than a few instructions.
+	class ConflictMatrix {
+		ConflictMatrix(const ConflictMatrix&);            // DO NOT IMPLEMENT
+		ConflictMatrix& operator=(const ConflictMatrix&); // DO NOT IMPLEMENT
+
+		/// An access of a call site to a memory object.
+		struct Access {
+			unsigned object;
+			ArgModRefResult modRef;
+			std::string name; // of the argument pointing to a DS node
+
+			Access(unsigned o, ArgModRefResult m, StringRef n)
+				: object(o), modRef(m), name(n) { }
+
+			bool operator<(const Access &rhs) const { return object < rhs.object; }
+		};
+
+		typedef std::vector<Access> AccessVecTy;
+
+		AnalysisContext *ctx_;
+		std::vector<Instruction*> sites_;
+		std::vector<AccessVecTy> accesses_;          // per call site
+		DenseMap<const DSNode*, unsigned> nodeNums_; // node -> object
+		DenseMap<unsigned, unsigned> globalNums_;    // global number -> object
+		std::vector<int> objectGlobals_;             // object -> global or -1
+		unsigned numWords_;                          // per row
+		std::vector<uint64_t> reads_, writes_;       // one row per call site
+
+		/// returns the object of the global with the given number
+		unsigned getGlobalObject(unsigned global);
+
+		/// sorts the accesses of every call site and fills the rows
+		void buildRows(void);
+
+		/// returns the access of the call site to the object
+		const Access &getAccess(unsigned site, unsigned object) const;
+
+		/// adds the dependence of two call sites caused by an object
+		void addConflict(DepGraph *dg, unsigned a, unsigned b, unsigned object,
+										 bool trueDep, bool antiDep, bool outputDep) const;
+
+	public:
+		explicit ConflictMatrix(AnalysisContext *ctx)
+			: ctx_(ctx), numWords_(0) { }
+
+		/// drops all call sites; the mod/ref summaries have to exist
+		void clear(void);
+
+		/// adds a call site and returns its number
+		unsigned addSite(Instruction *I);
+
+		/// returns the number of call sites
+		unsigned getNumSites(void) const { return sites_.size(); }
+
+		/// returns the call site with the given number
+		Instruction *getSite(unsigned site) const { return sites_[site]; }
+
+		/// records an access of the call site to a DS node through an argument
+		void addNode(unsigned site, const DSNode *node, ArgModRefResult modRef,
+								 StringRef name);
+
+		/// records the globals read and changed by the call site
+		void addGlobals(unsigned site, const BitVector &reads,
+										const BitVector &writes);
+
+		/// adds the dependences of all pairs of call sites to the graph, except
+		/// for the pairs of the call sites before firstNew
+		void addDependences(DepGraph *dg, unsigned firstNew = 0);
+	};
+}
+
+#endif /* PARPOT_CONFLICTMATRIX_H_ */
@@ -17,7 +17,8 @@ namespace llvm {
 	class CorrelationAnalysis: public Analysis {
 
 	public:
-		CorrelationAnalysis(AnalysisContext *ctx): Analysis(ctx) { };
+		CorrelationAnalysis(AnalysisContext *ctx, AnalysisCache *cache)
+			: Analysis(ctx, cache) { };
 
 		// the analyze method is expected to be overwritten
 		void analyze(Function*, Instruction*, Instruction*);
@@ -12,6 +12,7 @@
 
 #include "Analysis/DepGraph.h"
 
+#include <map>
 #include <set>
 
 namespace llvm {
@@ -31,7 +32,7 @@ namespace llvm {
 
 		// types
 		typedef std::vector<DepGraphNode *> DGNodeVecTy;
-		typedef std::set<Dependence *> DepSetTy;
+		typedef std::set<const Dependence *> DepSetTy;
 		typedef std::vector<DGNodeSet *> NodeSetVecTy;
 		typedef std::map<Function*, DepGraph*> DepGraphMapTy;
 
@@ -42,11 +43,15 @@ namespace llvm {
 		DepSetTy deps_;
 
 		double minSaving_, maxSaving_;
+		double minSavingLo_, minSavingHi_, maxSavingLo_, maxSavingHi_;
+		double score_, scoreLo_, scoreHi_;
 		unsigned trueDeps_, antiDeps_, outDeps_, cntDeps_, domDeps_;
+		bool rankStable_;
 
 		// helper-methods
 		bool findDeps(const DepGraph &graph, DepGraphNode *src, DepGraphNode *dst,
 									bool init = false);
+		double getDepFactor() const;
 	public:
 
 		DGNodeSet(const DepGraph &graph, const DGNodeVecTy &dSet,
@@ -70,6 +75,23 @@ namespace llvm {
 		double getMinSaving() const { return minSaving_; }
 		double getMaxSaving() const { return maxSaving_; }
 
+		// 95% confidence bounds of the savings
+		double getMinSavingLo() const { return minSavingLo_; }
+		double getMinSavingHi() const { return minSavingHi_; }
+		double getMaxSavingLo() const { return maxSavingLo_; }
+		double getMaxSavingHi() const { return maxSavingHi_; }
+
+		/// returns the ranking score and its 95% confidence bounds; the score
+		/// never exceeds the maximum saving
+		double getScore() const { return score_; }
+		double getScoreLo() const { return scoreLo_; }
+		double getScoreHi() const { return scoreHi_; }
+
+		/// a rank is stable, if the score interval doesn't overlap with the ones
+		/// of its neighbours
+		bool isRankStable() const { return rankStable_; }
+		void setRankStable(bool stable) { rankStable_ = stable; }
+
 		const DepGraph* getGraph(void) const { return graph_; }
 
 		static bool compare(const DGNodeSet*, const DGNodeSet*);
@@ -0,0 +1,78 @@
+//========== Analysis/DefUseIndex.h - Def-use reachability - Interface =======//
+//
+//                 ParPot - Parallelization Potential - Analysis
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the DefUseIndex class, which answers whether the
+// definition of a value reaches a call site of a function.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef PARPOT_DEFUSEINDEX_H_
+#define PARPOT_DEFUSEINDEX_H_
+
+#include "llvm/Function.h"
+#include "llvm/Instructions.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+
+#include <vector>
+
+namespace llvm {
+
+	/// The DefUseIndex class numbers the call sites of one function. For every
+	/// value queried, the use chains, stores and branches reachable from it are
+	/// walked once, and the call sites found are recorded in two bit sets: the
+	/// ones reached through a branch and the ones reached through values only.
+	/// Later queries for the same value are bit tests.
+	class DefUseIndex {
+		DefUseIndex(const DefUseIndex&);            // DO NOT IMPLEMENT
+		DefUseIndex& operator=(const DefUseIndex&); // DO NOT IMPLEMENT
+
+		/// The call sites reached from a value.
+		struct ReachSets {
+			BitVector viaValue;  // through use chains and stores only
+			BitVector viaBranch; // through a branch depending on the value
+		};
+
+		/// A value to visit and whether a branch lies on the path to it.
+		typedef std::pair<Value*, bool> WorkItemTy;
+
+		Function *func_;
+		DenseMap<const Instruction*, unsigned> callSites_;
+		DenseMap<const Value*, ReachSets*> reach_;
+
+		/// walks everything reachable from the value
+		void compute(Value *V, ReachSets &sets) const;
+
+		/// visits the blocks controlled by a branch
+		void visitBranch(BranchInst *B, ReachSets &sets,
+										 std::vector<WorkItemTy> &work,
+										 DenseSet<const BranchInst*> &branches) const;
+
+		/// records a call site of the function, if I is one
+		void mark(const Instruction *I, bool viaBranch, ReachSets &sets) const;
+
+	public:
+		DefUseIndex() : func_(0) { }
+		~DefUseIndex() { clear(); }
+
+		/// returns the function whose call sites are indexed or null
+		Function* getFunction(void) const { return func_; }
+
+		/// indexes the call sites of the given function; earlier results are
+		/// dropped
+		void reset(Function *F);
+
+		/// drops all results
+		void clear(void);
+
+		/// returns true if the definition of the value reaches the call site
+		/// through a branch or, if viaValue is set, through its uses alone
+		bool reaches(Value *V, const Instruction *callSite, bool viaValue);
+	};
+}
+
+#endif /* PARPOT_DEFUSEINDEX_H_ */
@@ -11,7 +11,10 @@
 #define PARPOT_ANALYSIS_DEPGRAPH_H
 
 #include "llvm/Instruction.h"
-#include <map>
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
 #include <vector>
 
 namespace llvm {
@@ -30,21 +33,21 @@ enum DependenceType {
   CorrelationDependece		= 0x40
 };
 
-/// dependence class
+/// dependence class; the object names are interned by the graph
 class Dependence {
+  typedef StringMapEntry<char> NameTy;
+
   DepGraphNode *pNode_;
   unsigned char depType_;
-  std::string ownObj_, fgnObj_;
+  const NameTy *ownObj_, *fgnObj_;
 
 public:
-  Dependence(DepGraphNode *node, DependenceType type, std::string ownObj,
-      std::string fgnObj, bool isIncoming) : pNode_(node),
+  Dependence(DepGraphNode *node, DependenceType type, const NameTy *ownObj,
+      const NameTy *fgnObj, bool isIncoming) : pNode_(node),
                     depType_(type | (isIncoming ? IncomingFlag : NoDependence)),
                     ownObj_(ownObj),
                     fgnObj_(fgnObj) { }
 
-  Dependence(const Dependence &D) : pNode_(D.pNode_), depType_(D.depType_) { }
-
   bool operator==(const Dependence &D) const {
     return (pNode_ == D.pNode_
 							&& depType_ == D.depType_
@@ -52,7 +55,7 @@ public:
 							&& fgnObj_ == D.fgnObj_);
   }
 
-  unsigned char getDepType(void) {
+  unsigned char getDepType(void) const {
     return depType_;
   }
 
@@ -60,26 +63,32 @@ public:
     return pNode_;
   }
 
-  std::string getOwnObj() const {
-    return ownObj_;
+  StringRef getOwnObj() const {
+    return ownObj_->getKey();
   }
 
-  std::string getFgnObj() const {
-    return fgnObj_;
+  StringRef getFgnObj() const {
+    return fgnObj_->getKey();
   }
 };
 
-/// DepGraphNode class
+/// DepGraphNode class; the dependences of a node are slices of arrays owned
+/// by the graph
 class DepGraphNode {
-  std::vector<Dependence *> incoming_;
-  std::vector<Dependence *> outgoing_;
+  friend class DepGraph;
+
   Instruction *pInstruction_;
+  unsigned index_;
+  Dependence *incoming_, *outgoing_;
+  unsigned numIncoming_, numOutgoing_;
 
   DepGraphNode(const DepGraphNode&);            // DO NOT IMPLEMENT
   DepGraphNode& operator=(const DepGraphNode*); // DO NOT IMPLEMENT
 
 public:
-  DepGraphNode(Instruction *instruction) : pInstruction_(instruction) { }
+  DepGraphNode(Instruction *instruction, unsigned index)
+    : pInstruction_(instruction), index_(index), incoming_(0), outgoing_(0),
+      numIncoming_(0), numOutgoing_(0) { }
 
   bool operator==(const DepGraphNode &rhs) const {
     return (pInstruction_ == rhs.pInstruction_);
@@ -89,60 +98,79 @@ public:
     return (pInstruction_ != rhs.pInstruction_);
   }
 
-  typedef std::vector<Dependence *>::iterator             iterator;
-  typedef std::vector<Dependence *>::const_iterator const_iterator;
+  typedef Dependence*                   iterator;
+  typedef const Dependence*       const_iterator;
 
-        iterator inDepBegin()       { return incoming_.begin(); }
-  const_iterator inDepBegin() const { return incoming_.begin(); }
-        iterator inDepEnd()         { return incoming_.end(); }
-  const_iterator inDepEnd()   const { return incoming_.end(); }
+        iterator inDepBegin()       { return incoming_; }
+  const_iterator inDepBegin() const { return incoming_; }
+        iterator inDepEnd()         { return incoming_ + numIncoming_; }
+  const_iterator inDepEnd()   const { return incoming_ + numIncoming_; }
 
-        iterator outDepBegin()       { return outgoing_.begin(); }
-  const_iterator outDepBegin() const { return outgoing_.begin(); }
-        iterator outDepEnd()         { return outgoing_.end(); }
-  const_iterator outDepEnd()   const { return outgoing_.end(); }
+        iterator outDepBegin()       { return outgoing_; }
+  const_iterator outDepBegin() const { return outgoing_; }
+        iterator outDepEnd()         { return outgoing_ + numOutgoing_; }
+  const_iterator outDepEnd()   const { return outgoing_ + numOutgoing_; }
 
-  void addDependency(Dependence *dep) {
-    if (dep->getDepType() & IncomingFlag)
-      incoming_.push_back(dep);
-    else
-      outgoing_.push_back(dep);
-  }
+  /// returns the dense index of the node within its graph
+  unsigned getIndex(void) const { return index_; }
 
-  Instruction* getInstruction(void) { return pInstruction_; }
+  Instruction* getInstruction(void) const { return pInstruction_; }
 };
 
-/// DepGraph class
+/// DepGraph class. Nodes, dependences and object names live in an arena that
+/// is freed with the graph. New dependences are collected until finalize()
+/// packs the dependences of every node into contiguous slices.
 class DepGraph {
   DepGraph(const DepGraph&);            // DO NOT IMPLEMENT
   DepGraph& operator=(const DepGraph*); // DO NOT IMPLEMENT
 
-  typedef std::map<Instruction*, DepGraphNode*> DepNodeMapTy;
-  Function *pFunction_;
-  DepNodeMapTy depNodeMap_;
+  /// A dependence that has not been packed yet.
+  struct PendingDep {
+    unsigned from, to;
+    DependenceType type;
+    const StringMapEntry<char> *ownObj, *fgnObj;
+    PendingDep(unsigned f, unsigned t, DependenceType d,
+               const StringMapEntry<char> *own, const StringMapEntry<char> *fgn)
+      : from(f), to(t), type(d), ownObj(own), fgnObj(fgn) { }
+  };
 
-public:
-  DepGraph(Function *function): pFunction_(function) { }
+  typedef std::vector<DepGraphNode*> DepNodeVecTy;
 
-  ~DepGraph() {
-    for (iterator it = depNodeMap_.begin(), e = depNodeMap_.end();
-          it != e; ++it)
-      delete it->second;
+  Function *pFunction_;
+  BumpPtrAllocator allocator_;                 // nodes and dependences
+  StringMap<char, BumpPtrAllocator&> names_;   // interned object names
+  DepNodeVecTy nodes_;                         // by index
+  DenseMap<const Instruction*, unsigned> nodeIndex_;
+  std::vector<PendingDep> pending_;
+
+  const StringMapEntry<char> *intern(StringRef name) {
+    return &names_.GetOrCreateValue(name);
   }
 
-  typedef DepNodeMapTy::iterator                        iterator;
-  typedef DepNodeMapTy::const_iterator            const_iterator;
+public:
+  DepGraph(Function *function): pFunction_(function), names_(allocator_) { }
+
+  typedef DepNodeVecTy::iterator                        iterator;
+  typedef DepNodeVecTy::const_iterator            const_iterator;
 
-  iterator begin(void) { return depNodeMap_.begin(); }
-  iterator end(void) { return depNodeMap_.end(); }
-  const_iterator begin(void) const { return depNodeMap_.begin(); }
-  const_iterator end(void) const { return depNodeMap_.end(); }
+  iterator begin(void) { return nodes_.begin(); }
+  iterator end(void) { return nodes_.end(); }
+  const_iterator begin(void) const { return nodes_.begin(); }
+  const_iterator end(void) const { return nodes_.end(); }
 
   DepGraphNode* getNode(Instruction *cs, bool createIfMissing = false);
   const DepGraphNode* getNode(const Instruction *cs) const;
 
+  /// adds a dependence; it is visible at the nodes after finalize()
   void addDependence(Instruction *iA, Instruction *iB,
-      DependenceType depType, std::string ownObj, std::string fgnObj);
+      DependenceType depType, StringRef ownObj, StringRef fgnObj);
+
+  /// packs the dependences added since the last call; the dependences added
+  /// before keep their order
+  void finalize(void);
+
+  /// returns true if all dependences are visible at the nodes
+  bool isFinalized(void) const { return pending_.empty(); }
 
   Function* getFunction(void) const { return pFunction_; }
 };
@@ -17,7 +17,8 @@ namespace llvm {
 	class DominatorAnalysis: public Analysis {
 
 	public:
-		DominatorAnalysis(AnalysisContext *ctx): Analysis(ctx) { };
+		DominatorAnalysis(AnalysisContext *ctx, AnalysisCache *cache)
+			: Analysis(ctx, cache) { };
 
 		// the analyze method is expected to be overwritten
 		void analyze(Function*, Instruction*, Instruction*);
@@ -12,16 +12,21 @@
 #define PARPOT_GLOBALSANALYSIS_H_
 
 #include "Analysis/Analysis.h"
+#include "Analysis/ConflictMatrix.h"
 
 namespace llvm {
 	class GlobalsAnalysis: public Analysis {
 
 	public:
-		GlobalsAnalysis(AnalysisContext *ctx): Analysis(ctx) { };
+		GlobalsAnalysis(AnalysisContext *ctx, AnalysisCache *cache)
+			: Analysis(ctx, cache) { };
 
 		// the analyze method is expected to be overwritten
 		void analyze(Function*, Instruction*, Instruction*);
 
+		/// records the globals read and changed by the call site of the matrix
+		void addAccesses(ConflictMatrix&, unsigned site);
+
 	private:
 		GlobalsAnalysis(const GlobalsAnalysis&);            // DO NOT IMPL
 		GlobalsAnalysis& operator=(const GlobalsAnalysis*); // DO NOT IMPL
@@ -0,0 +1,117 @@
+//===---- Analysis/LoopTimeInfo.h - Loop time-profiling info - Interface --===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the LoopTimeRecord class, which holds the time-profiling
+// information of a single loop, and the numbering of loops that is shared by
+// the loop instrumentation and the profile loader.
+//
+//===----------------------------------------------------------------------===//
+#ifndef PARPOT_ANALYSIS_LOOPTIMEINFO_H
+#define PARPOT_ANALYSIS_LOOPTIMEINFO_H
+
+#include "Analysis/TimeProfileInfoTypes.h"
+#include "Support/RunningStat.h"
+#include "llvm/Analysis/LoopInfo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace llvm {
+
+  /// The LoopTimeRecord class describes the execution of a loop: how often it
+  /// was entered, its total time and the distribution of its iteration times.
+  class LoopTimeRecord {
+    double invocations_;
+    double total_;
+    double iterMin_, iterMax_;
+    RunningStat iterStat_; // weight = number of iterations
+
+  public:
+    LoopTimeRecord(): invocations_(0.0), total_(0.0), iterMin_(0.0),
+                      iterMax_(0.0) { }
+
+    /// adds the raw record of a run (see LoopTimeRecordField) with the given
+    /// weight.
+    void add(const double *rec, double weight);
+
+    double getInvocations() const { return invocations_; }
+    double getTrips() const { return iterStat_.getWeight(); }
+    double getTotalTime() const { return total_; }
+    double getIterMin() const { return iterMin_; }
+    double getIterMax() const { return iterMax_; }
+    const RunningStat &getIterStat() const { return iterStat_; }
+
+    /// returns the average number of iterations per invocation
+    double getTripsPerInvocation() const {
+      return invocations_ > 0.0 ? getTrips() / invocations_ : 0.0;
+    }
+
+    /// estimates the load imbalance of a DOALL execution with static chunks on
+    /// the given number of threads: the expected time of the slowest chunk
+    /// relative to the mean chunk time, minus one.
+    double getDoallImbalance(unsigned threads) const;
+
+    /// estimates the time saved by a DOALL execution on the given number of
+    /// threads.
+    double getDoallSaving(unsigned threads) const;
+  };
+
+  inline void LoopTimeRecord::add(const double *rec, double weight) {
+    if (rec[LoopTrips] > 0.0) {
+      if (iterStat_.empty() || rec[LoopIterMin] < iterMin_)
+        iterMin_ = rec[LoopIterMin];
+      if (iterStat_.empty() || rec[LoopIterMax] > iterMax_)
+        iterMax_ = rec[LoopIterMax];
+      iterStat_.merge(RunningStat(weight * rec[LoopTrips], rec[LoopIterMean],
+                                  weight * rec[LoopIterM2]));
+    }
+    invocations_ += weight * rec[LoopInvocations];
+    total_ += weight * rec[LoopTotal];
+  }
+
+  inline double LoopTimeRecord::getDoallImbalance(unsigned threads) const {
+    double trips = getTripsPerInvocation();
+    if (threads < 2 || trips < 2.0 || iterStat_.getMean() <= 0.0)
+      return 0.0;
+
+    // the expected maximum of the chunk sums is approximated by the normal
+    // distribution: mean + sigma * sqrt(2 ln threads)
+    double chunk = std::max(1.0, trips / threads);
+    double chunkMean = chunk * iterStat_.getMean();
+    double chunkDev = std::sqrt(chunk * iterStat_.getVariance());
+    double spread = std::sqrt(2.0 * std::log((double)threads));
+    double slowest = chunkMean + chunkDev * spread;
+    return slowest / chunkMean - 1.0;
+  }
+
+  inline double LoopTimeRecord::getDoallSaving(unsigned threads) const {
+    double trips = getTripsPerInvocation();
+    if (threads < 2 || trips < 2.0)
+      return 0.0;
+
+    // the parallel loop takes at least as long as its slowest chunk
+    double used = std::min<double>(threads, trips);
+    double parallel = total_ / used * (1.0 + getDoallImbalance(threads));
+    return std::max(0.0, total_ - parallel);
+  }
+
+  // addProfiledLoop - Appends a loop and its nested loops in preorder.
+  inline void addProfiledLoop(Loop *L, std::vector<Loop*> &loops) {
+    loops.push_back(L);
+    for (Loop::iterator it = L->begin(), e = L->end(); it != e; ++it)
+      addProfiledLoop(*it, loops);
+  }
+
+  /// collects the loops of a function in the order in which they are numbered
+  /// by the loop time profiling. Functions are numbered in module order.
+  inline void getProfiledLoops(const LoopInfo &LI, std::vector<Loop*> &loops) {
+    for (LoopInfo::iterator it = LI.begin(), e = LI.end(); it != e; ++it)
+      addProfiledLoop(*it, loops);
+  }
+}
+
+#endif
@@ -0,0 +1,107 @@
+//======= Analysis/ModRefSummary.h - Mod/ref summaries - Interface ===========//
+//
+//                 ParPot - Parallelization Potential - Analysis
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the ModRefSummary class, which computes how every function
+// accesses its pointer arguments and the global variables, including the
+// accesses of the functions it calls.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef PARPOT_MODREFSUMMARY_H_
+#define PARPOT_MODREFSUMMARY_H_
+
+#include "Analysis/AnalysisContext.h"
+
+#include "llvm/ADT/BitVector.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace llvm {
+
+	enum ArgModRefResult {
+		NoModRef = 0x0,
+		Ref			 = 0x1,
+		Mod			 = 0x2,
+		ModRef 	 = 0x3
+	};
+
+	inline ArgModRefResult& operator|=(ArgModRefResult &lhs,
+																		 ArgModRefResult rhs) {
+		lhs = static_cast<ArgModRefResult>((int)lhs | (int)rhs);
+		return lhs;
+	}
+
+	/// The accesses of a function to its pointer arguments and to globals.
+	struct FunctionModRef {
+		std::vector<ArgModRefResult> args; // by argument number
+		BitVector reads, writes;           // by number of the global
+	};
+
+	/// The ModRefSummary class computes the summaries of all defined functions
+	/// bottom-up over the strongly connected components of the call graph,
+	/// iterating each component to a fixpoint. Callees are resolved by the
+	/// analysis context, so indirect calls follow the dynamic call graph.
+	/// The globals of the module are numbered; the direct accesses are found
+	/// once by walking the uses of every global, and the accesses of callees
+	/// are merged as bit sets. Afterwards, every query is a table lookup.
+	class ModRefSummary {
+		ModRefSummary(const ModRefSummary&);            // DO NOT IMPLEMENT
+		ModRefSummary& operator=(const ModRefSummary&); // DO NOT IMPLEMENT
+
+		typedef std::map<const Function*, FunctionModRef> SummaryMapTy;
+		typedef std::vector<Function*> FuncVecTy;
+
+		AnalysisContext &ctx_;
+		SummaryMapTy summaries_;
+		std::vector<GlobalVariable*> globals_; // by number
+		BitVector noGlobals_;                  // of functions without summary
+
+		// state of Tarjan's algorithm
+		std::map<Function*, unsigned> index_, lowLink_;
+		FuncVecTy stack_;
+		std::set<Function*> onStack_;
+
+		/// records the direct loads and stores of the global with the given
+		/// number through the value, which is the global or derived from it
+		void indexGlobal(unsigned num, Value *V);
+
+		/// finds the components reachable from the function
+		void visit(Function *F);
+
+		/// computes the summaries of a component up to the fixpoint
+		void computeComponent(const FuncVecTy &component);
+
+		/// recomputes the summary of a function; returns true if it changed
+		bool computeFunction(Function *F);
+
+		/// analyzes how the function accesses the given value and the values
+		/// derived from it
+		ArgModRefResult getModRefForValue(const Value *V,
+																			std::set<const Value*> &visited) const;
+
+	public:
+		explicit ModRefSummary(AnalysisContext &ctx);
+
+		/// returns how the function accesses the argument with the given number
+		ArgModRefResult getModRefForArg(const Function *F, unsigned argNo) const;
+
+		/// returns the number of globals of the module
+		unsigned getNumGlobals(void) const { return globals_.size(); }
+
+		/// returns the global with the given number
+		GlobalVariable *getGlobal(unsigned num) const { return globals_[num]; }
+
+		/// returns the globals read by the function and its callees
+		const BitVector &getReads(const Function *F) const;
+
+		/// returns the globals changed by the function and its callees
+		const BitVector &getWrites(const Function *F) const;
+	};
+}
+
+#endif /* PARPOT_MODREFSUMMARY_H_ */
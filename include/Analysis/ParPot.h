@@ -15,13 +15,16 @@
 #include "Analysis/Analysis.h"
 #include "Analysis/TimeProfileInfo.h"
 #include "Analysis/CorrelationAnalysis.h"
+#include "Analysis/DominatorAnalysis.h"
 #include "Analysis/PointerAnalysis.h"
 #include "Analysis/GlobalsAnalysis.h"
 #include "Analysis/CountStoresPass.h"
 #include "Analysis/TimeProfileInfoLoader.h"
 #include "Analysis/AnalysisContext.h"
+#include "Analysis/ConflictMatrix.h"
 #include "Analysis/DGNodeSet.h"
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Analysis/Passes.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/Value.h"
@@ -35,10 +38,13 @@
 #include <math.h>
 #include <map>
 #include <queue>
+#include <set>
 #include <vector>
 
 namespace llvm {
 
+	class DebugInfoReader;
+
 	/// ParPot class -
 	class ParPot: public ModulePass {
 	public:
@@ -53,22 +59,109 @@ namespace llvm {
 		// constants
 		static const std::string Separator;
 
+		/// The node sets of an additional profile (-parpot-profile).
+		struct ProfileResult {
+			std::string name;
+			DynCallGraph *dcg;
+			DGNodeSet::NodeSetVecTy nodeSets;
+
+			ProfileResult(const std::string &n, DynCallGraph *g)
+				: name(n), dcg(g) { }
+		};
+
+		/// The call sites of a function whose pairs are analyzed. The pairs of
+		/// the nodes before firstNew were analyzed with an earlier profile; the
+		/// nodes from firstNew on are new or call functions they didn't call
+		/// before.
+		struct FunctionWork {
+			Function *function;
+			DepGraph *graph;
+			std::vector<DepGraphNode*> nodes;
+			unsigned firstNew;
+
+			FunctionWork(Function *f, DepGraph *g)
+				: function(f), graph(g), firstNew(0) { }
+		};
+
+		/// The executed call sites of a function with their callees.
+		typedef std::pair<Instruction*, AnalysisContext::CalleeVecTy> CallSiteTy;
+		typedef std::vector<CallSiteTy> CallSiteVecTy;
+
+		/// The analyses of one thread and their cache.
+		struct AnalysisWorker {
+			AnalysisCache cache;
+			ConflictMatrix conflicts; // of the function analyzed last
+			PointerAnalysis pointerAnalysis;
+			CorrelationAnalysis corrAnalysis;
+			GlobalsAnalysis globalsAnalysis;
+			DominatorAnalysis domAnalysis;
+
+			explicit AnalysisWorker(AnalysisContext *ctx)
+				: conflicts(ctx), pointerAnalysis(ctx, &cache),
+				  corrAnalysis(ctx, &cache), globalsAnalysis(ctx, &cache),
+				  domAnalysis(ctx, &cache) { }
+		};
+
+		class AnalyzeTask; // analyzes the functions on several threads
+
 		// members
 		AnalysisContext *ctx_;
-		PointerAnalysis *pointerAnalysis;
-		CorrelationAnalysis *corrAnalysis;
-		GlobalsAnalysis *globalsAnalysis;
+		std::vector<AnalysisWorker*> workers_;
+		std::set<Function*> visitedFuncs_;
+		std::vector<ProfileResult> profiles_;
+		/// the sorted callees of each call site its pairs were analyzed with
+		DenseMap<Instruction*, std::vector<Function*> > analyzedCallees_;
 
 		/// analyze dependence graph of a given ParPotNode and all children
 		void analyzeDependencies(Function*);
 
+		/// create the dependence graphs of a function and all functions it calls
+		/// that haven't been analyzed yet, and extend the graphs by the call
+		/// sites executed with the current profile only or calling further
+		/// functions with it
+		void collectFunctions(Function*, std::vector<FunctionWork> &work);
+
+		/// collect the call sites of a function executed with the current
+		/// profile; returns false if their combined time is below the minimum
+		/// fraction of the total time, so no set of the function can reach it
+		bool collectCallSites(Function*, CallSiteVecTy &sites) const;
+
+		/// record the callees of a call site; returns true if it calls a
+		/// function its pairs haven't been analyzed with
+		bool addAnalyzedCallees(const CallSiteTy&);
+
+		/// analyze every pair of call sites of a function; memory conflicts are
+		/// found for all pairs at once
+		static void analyzeFunction(const FunctionWork&, AnalysisWorker&);
+
 		/// collect every set of nodes which are at the same level (has the same
 		/// parent)
-		void collectNodeSets(Function *parent);
+		void collectNodeSets(Function *parent, DGNodeSet::NodeSetVecTy &sets);
+
+		/// add the set of two callsites to the best sets found so far unless its
+		/// saving, which is at most the given bound, can't be among them; the
+		/// sets form a heap with the worst set in front
+		void addNodeSet(DepGraph *graph, DepGraphNode *nodeA,
+		                DepGraphNode *nodeB, double bound,
+		                DGNodeSet::NodeSetVecTy &sets);
+
+		/// collect, sort and rank the node sets using the current profile
+		void evaluateProfile(Function *root, DGNodeSet::NodeSetVecTy &sets);
+
+		/// evaluate the additional profiles with the same dependence analysis
+		void evaluateProfiles(Module &M, Function *root);
+
+		/// flag the sorted node sets whose rank isn't statistically stable
+		void markUnstableRanks(DGNodeSet::NodeSetVecTy &sets);
 
 		/// helper function to print a dependency type string
 		void printDepType(raw_ostream&, unsigned char type) const;
 
+		/// dump the node sets found with the given profile
+		void printNodeSets(raw_ostream&, DebugInfoReader &reader,
+		                   const DGNodeSet::NodeSetVecTy &sets,
+		                   const DynCallGraph &dcg) const;
+
 	public:
 		static char ID; // Class identification, replacement for typeinfo
 		ParPot() : ModulePass(ID) { }
@@ -78,6 +171,9 @@ namespace llvm {
 			for (DGNodeSet::DepGraphMapTy::const_iterator it = graphs->begin(),
 						e = graphs->end(); it != e; ++ it)
 				delete it->second;
+			for (unsigned i = 0, e = profiles_.size(); i != e; ++i)
+				delete profiles_[i].dcg;
+			DeleteContainerPointers(workers_);
 		}
 
 		virtual bool runOnModule(Module &M);
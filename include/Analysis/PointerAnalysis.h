@@ -12,16 +12,22 @@
 #define PARPOT_POINTERANALYSIS_H_
 
 #include "Analysis/Analysis.h"
+#include "Analysis/ConflictMatrix.h"
 
 namespace llvm {
 
 	class PointerAnalysis: public Analysis {
 	public:
-		PointerAnalysis(AnalysisContext* tool): Analysis(tool) { };
+		PointerAnalysis(AnalysisContext* tool, AnalysisCache *cache)
+			: Analysis(tool, cache) { };
 
 		// the analyze method is expected to be overwritten
 		void analyze(Function*, Instruction*, Instruction*);
 
+		/// records the DS nodes the call sites of the matrix access through
+		/// their pointer arguments
+		void addAccesses(Function *parent, ConflictMatrix&);
+
 	private:
 		PointerAnalysis(const PointerAnalysis&);            // DO NOT IMPLEMENT
 		PointerAnalysis& operator=(const PointerAnalysis*); // DO NOT IMPLEMENT
@@ -15,6 +15,8 @@
 #include "llvm/BasicBlock.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Analysis/ProfileInfo.h"
+#include "Analysis/LoopTimeInfo.h"
+#include "Support/RunningStat.h"
 #include <vector>
 #include <map>
 
@@ -31,6 +33,15 @@ namespace llvm {
 		typedef std::pair<const Function*, int> Priority;
 		typedef std::vector<Priority> PrioList;
 
+		/// A profiled loop that may be executed as DOALL loop.
+		struct LoopCandidate {
+			const Function *F;
+			const BasicBlock *Header;
+			unsigned Depth;
+			LoopTimeRecord Record;
+		};
+		typedef std::vector<LoopCandidate> LoopCandidateList;
+
 	private:
 		// static attributes to calculate priority informations
 		double static minExTime, maxExTime, totExTime;
@@ -40,6 +51,14 @@ namespace llvm {
 		// function executions.
 		std::map<const Function*, double> FunctionTimeInformation;
 
+		// FunctionTimeStats stores the distribution of the execution times over
+		// several profiling runs.
+		std::map<const Function*, RunningStat> FunctionTimeStats;
+
+		// LoopCandidates holds the profiled loops, sorted by the estimated
+		// saving of a DOALL execution.
+		LoopCandidateList LoopCandidates;
+
 		// PrioInformation holds the calculated priority value by some
 		// heuristics.
 		std::map<const Function*, int> PrioInformation;
@@ -59,6 +78,19 @@ namespace llvm {
 	    }
 		void setExecutionTime(const Function *F, const double&);
 
+		/// returns the execution time statistics of F over all profiled runs or
+		/// null, if there are none.
+		const RunningStat *getExecutionTimeStat(const Function *F) const {
+		  std::map<const Function*, RunningStat>::const_iterator J =
+		    FunctionTimeStats.find(F);
+		  if (J == FunctionTimeStats.end()) return 0;
+
+		  return &J->second;
+		}
+		void setExecutionTimeStat(const Function *F, const RunningStat &stat) {
+		  FunctionTimeStats[F] = stat;
+		}
+
 		int getPrioInformation(const Function *F) const {
 			std::map<const Function*, int>::const_iterator J =
 					PrioInformation.find(F);
@@ -69,6 +101,11 @@ namespace llvm {
 
 		void setPrioInformation(const Function*, const int&);
 
+		/// returns the profiled loops, most promising first
+		const LoopCandidateList &getLoopCandidates() const {
+			return LoopCandidates;
+		}
+
 		double static getTotalExTime() {
 			return TimeProfileInfo::getTotalExTime();
 		}
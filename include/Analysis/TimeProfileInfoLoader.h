@@ -20,6 +20,8 @@
 #include "llvm/Support/Format.h"
 #include "Analysis/TimeProfileInfoLoader.h"
 #include "Analysis/TimeProfileInfo.h"
+#include "Analysis/LoopTimeInfo.h"
+#include "Support/RunningStat.h"
 #include "llvm/Analysis/ProfileInfo.h"
 #include "llvm/Pass.h"
 
@@ -32,6 +34,8 @@ namespace llvm {
     Module &M;
     std::vector<std::string> CommandLines;
     std::vector<double>    FunctionTimes;
+    std::vector<RunningStat> FunctionTimeStats;
+    std::vector<LoopTimeRecord> LoopTimes;
   public:
     // ProfileInfoLoader ctor - Read the specified profiling data file, exiting
     // the program if the file is invalid or broken.
@@ -57,6 +61,20 @@ namespace llvm {
     const std::vector<double> &getRawFunctionTimes() const {
       return FunctionTimes;
     }
+
+    // getFunctionTimeStats - This method delivers the distribution of the
+    // execution times of functions over the profiled runs.
+    //
+    const std::vector<RunningStat> &getFunctionTimeStats() const {
+      return FunctionTimeStats;
+    }
+
+    // getLoopTimes - This method delivers the time records of loops, numbered
+    // like getProfiledLoops does.
+    //
+    const std::vector<LoopTimeRecord> &getLoopTimes() const {
+      return LoopTimes;
+    }
   };
 
   /// The TimeLoaderPass class declares a llvm-pass to read profiling 
@@ -75,6 +93,7 @@ namespace llvm {
     virtual void getAnalysisUsage(AnalysisUsage &AU) const {
       AU.setPreservesAll();
       AU.addRequired<ProfileInfo>();
+      AU.addRequired<LoopInfo>();
     }
 
     virtual const char *getPassName() const {
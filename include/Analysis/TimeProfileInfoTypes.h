@@ -15,7 +15,23 @@
 
 enum TimeProfilingType {
   ArgumentInfo  = 1,   /* The command line argument block */
-  FunctionTInfo = 8	   /* Function time-profiling information */
+  FunctionTInfo = 8,	   /* Function time-profiling information */
+  RunWeightInfo = 9,	   /* Weight of the following packets of a merged run */
+  LoopTInfo     = 10   /* Loop time-profiling information */
+};
+
+/* Layout of the record of a single loop within a LoopTInfo packet. All fields
+ * are doubles; times are measured in cycles.
+ */
+enum LoopTimeRecordField {
+  LoopInvocations = 0, /* number of times the loop was entered */
+  LoopTrips,           /* total number of iterations */
+  LoopTotal,           /* total time spent in the loop */
+  LoopIterMin,         /* shortest iteration */
+  LoopIterMax,         /* longest iteration */
+  LoopIterMean,        /* mean time of an iteration */
+  LoopIterM2,          /* sum of squared deviations of the iteration times */
+  LoopRecordSize
 };
 
 #endif
@@ -0,0 +1,172 @@
+//===------ DynCallGraph/CallSiteID.h - Call-site identifiers - Interface -===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the module-qualified call-site IDs that link the nodes of
+// a dynamic call graph to the call instructions of the program. An ID consists
+// of a hash of the functions defined by the module (upper 32 bits) and the
+// index of the call site within its module (lower 32 bits). The hash doesn't
+// depend on the path or name of the module, so a copy of it elsewhere yields
+// the same IDs. IDs are recorded as "parpot.csid" metadata and the hash as
+// "parpot.module.hash" named metadata, so they survive linking, and modules
+// can be instrumented separately. ID 0 is reserved for the main function.
+//
+//===----------------------------------------------------------------------===//
+#ifndef PARPOT_DYNCALLGRAPH_CALLSITEID_H
+#define PARPOT_DYNCALLGRAPH_CALLSITEID_H
+
+#include "llvm/Constants.h"
+#include "llvm/Instructions.h"
+#include "llvm/LLVMContext.h"
+#include "llvm/Metadata.h"
+#include "llvm/Module.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/InstIterator.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+  /// name of the metadata kind holding the ID of a call site
+  static const char *const CallSiteIDKind = "parpot.csid";
+
+  /// name of the named metadata holding the hash of the module
+  static const char *const ModuleHashKind = "parpot.module.hash";
+
+  typedef std::pair<uint64_t, Instruction*> CallSiteIDEntry;
+
+  /// returns the 32 bit hash (FNV-1a) of the sorted names of the functions
+  /// defined by M. Instrumentation only adds declarations, so instrumented
+  /// and uninstrumented copies of a module agree.
+  inline uint32_t computeModuleHash(const Module &M) {
+    std::vector<std::string> names;
+    for (Module::const_iterator F = M.begin(), E = M.end(); F != E; ++F)
+      if (!F->isDeclaration())
+        names.push_back(F->getName().str());
+    std::sort(names.begin(), names.end());
+
+    uint32_t hash = 2166136261U;
+    for (std::vector<std::string>::const_iterator name = names.begin(),
+          end = names.end(); name != end; ++name) {
+      // the terminating 0 separates the names
+      for (const char *it = name->c_str(), *e = it + name->size() + 1;
+           it != e; ++it) {
+        hash ^= (unsigned char)*it;
+        hash *= 16777619U;
+      }
+    }
+    return hash;
+  }
+
+  /// returns the hash of the module recorded at instrumentation time or, if
+  /// there is none, the computed one. A linked module keeps the hash of its
+  /// first part.
+  inline uint32_t getModuleHash(const Module &M) {
+    if (NamedMDNode *hashes = M.getNamedMetadata(ModuleHashKind))
+      if (hashes->getNumOperands() > 0) {
+        MDNode *node = hashes->getOperand(0);
+        if (node->getNumOperands() == 1)
+          if (ConstantInt *hash =
+                dyn_cast_or_null<ConstantInt>(node->getOperand(0)))
+            return (uint32_t)hash->getZExtValue();
+      }
+    return computeModuleHash(M);
+  }
+
+  /// records the hash of the module unless it has one.
+  inline void setModuleHash(Module &M, uint32_t hash) {
+    NamedMDNode *hashes = M.getOrInsertNamedMetadata(ModuleHashKind);
+    if (hashes->getNumOperands() > 0)
+      return;
+    LLVMContext &context = M.getContext();
+    Value *op = ConstantInt::get(Type::getInt32Ty(context), hash);
+    hashes->addOperand(MDNode::get(context, op));
+  }
+
+  /// returns the ID of a call site or 0 if it has none.
+  inline uint64_t getCallSiteID(const Instruction *I) {
+    MDNode *node = I->getMetadata(CallSiteIDKind);
+    if (!node || node->getNumOperands() != 1)
+      return 0;
+    if (ConstantInt *id = dyn_cast_or_null<ConstantInt>(node->getOperand(0)))
+      return id->getZExtValue();
+    return 0;
+  }
+
+  /// records the ID of a call site.
+  inline void setCallSiteID(Instruction *I, uint64_t id) {
+    LLVMContext &context = I->getContext();
+    Value *op = ConstantInt::get(Type::getInt64Ty(context), id);
+    I->setMetadata(CallSiteIDKind, MDNode::get(context, op));
+  }
+
+  /// collects the IDs of all call sites of M in module order. Call sites
+  /// without an ID get the next free index of the module; with assign set the
+  /// ID and the module hash are also recorded. For a module without IDs this
+  /// yields the same IDs as assigning them, so uninstrumented copies of a
+  /// module agree with the instrumented one.
+  inline void collectCallSiteIDs(Module &M,
+                                 std::vector<CallSiteIDEntry> &ids,
+                                 bool assign) {
+    uint64_t hash = getModuleHash(M);
+    if (assign)
+      setModuleHash(M, (uint32_t)hash);
+    uint32_t maxLocal = 0;
+    for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F)
+      for (inst_iterator it = inst_begin(F), e = inst_end(F); it != e; ++it)
+        if (uint64_t id = getCallSiteID(&*it))
+          if ((id >> 32) == hash)
+            maxLocal = std::max(maxLocal, (uint32_t)id);
+
+    for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F) {
+      if (F->isDeclaration()) continue;
+      for (inst_iterator it = inst_begin(F), e = inst_end(F); it != e; ++it) {
+        if (!isa<CallInst>(&*it) && !isa<InvokeInst>(&*it))
+          continue;
+        uint64_t id = getCallSiteID(&*it);
+        if (!id) {
+          id = (hash << 32) | ++maxLocal;
+          if (assign)
+            setCallSiteID(&*it, id);
+        }
+        ids.push_back(std::make_pair(id, &*it));
+      }
+    }
+  }
+
+  /// The class CallSiteTable maps call-site IDs to their instructions. It is
+  /// a sorted vector, so lookups are binary searches.
+  class CallSiteTable {
+    std::vector<CallSiteIDEntry> table_;
+
+    CallSiteTable(const CallSiteTable&);   // DO NOT IMPLEMENT
+    void operator=(const CallSiteTable&);  // DO NOT IMPLEMENT
+
+  public:
+    explicit CallSiteTable(Module &M) {
+      collectCallSiteIDs(M, table_, /*assign*/ false);
+      std::sort(table_.begin(), table_.end());
+    }
+
+    typedef std::vector<CallSiteIDEntry>::const_iterator const_iterator;
+    const_iterator begin() const { return table_.begin(); }
+    const_iterator end()   const { return table_.end(); }
+    size_t size() const { return table_.size(); }
+
+    /// returns the call site with the given ID or null.
+    Instruction *lookup(uint64_t id) const {
+      const_iterator it = std::lower_bound(table_.begin(), table_.end(),
+                            CallSiteIDEntry(id, (Instruction*)0));
+      if (it == table_.end() || it->first != id)
+        return 0;
+      return it->second;
+    }
+  };
+}
+
+#endif
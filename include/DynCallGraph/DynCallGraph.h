@@ -15,10 +15,17 @@
 #include "llvm/Function.h"
 #include "llvm/Support/CallSite.h"
 #include "llvm/Support/ValueHandle.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/GraphTraits.h"
 #include "llvm/Support/DOTGraphTraits.h"
 #include "llvm/Instruction.h"
+#include "llvm/Support/Allocator.h"
+#include "DynCallGraph/CallSiteID.h"
+#include "Support/QuantileSketch.h"
+#include "Support/RunningStat.h"
 #include <map>
 #include <vector>
 #include <sstream>
@@ -27,56 +34,79 @@ namespace llvm {
 
 /// The class DynCallGraphNode represents a function node of the dynamic call
 /// graph. It holds the ID as well as the corresponding name of the function
-/// node.
+/// node. Nodes, their names and their call lists live in the arena of their
+/// DynCallGraph.
 class DynCallGraphNode {
+public:
+  typedef std::pair<DynCallGraphNode*, unsigned> calledFunctionTy;
+
+private:
   unsigned nodeID_;
-  std::string name_;
-  unsigned num_;
+  StringRef name_;   // interned by the graph
+  uint64_t num_;     // call-site ID (see CallSiteID.h)
   Instruction *pInstruction_;
   double exTime_;
+  RunningStat stat_; // execution time per profiled run
+  calledFunctionTy *calledFunctions_;  // set by DynCallGraph::finalize()
+  unsigned numCalledFunctions_;
 
   DynCallGraphNode(const DynCallGraphNode&);  // DO NOT IMPLEMENT
   void operator=(const DynCallGraphNode&);    // DO NOT IMPLEMENT
 
-public:
-  typedef std::pair<DynCallGraphNode*, unsigned> calledFunctionTy;
-
-private:
-  std::vector<calledFunctionTy> calledFunctions_;
+  friend class DynCallGraph;
 
 public:
-  DynCallGraphNode(unsigned id, std::string name, unsigned num, double exTime)
-    : nodeID_(id), name_(name), num_(num), exTime_(exTime) { }
+  DynCallGraphNode(unsigned id, StringRef name, uint64_t num, double exTime,
+                   const RunningStat &stat)
+    : nodeID_(id), name_(name), num_(num), pInstruction_(0), exTime_(exTime),
+      stat_(stat), calledFunctions_(0), numCalledFunctions_(0) { }
 
   //===---------------------------------------------------------------------
   // Accessor methods.
   //
-  typedef std::vector<calledFunctionTy>::iterator iterator;
-  typedef std::vector<calledFunctionTy>::const_iterator const_iterator;
-
-  inline iterator begin() { return calledFunctions_.begin(); }
-  inline iterator end()   { return calledFunctions_.end();   }
-  inline const_iterator begin() const { return calledFunctions_.begin(); }
-  inline const_iterator end()   const { return calledFunctions_.end();   }
-  inline bool empty() const { return calledFunctions_.empty(); }
-  inline unsigned size() const { return (unsigned)calledFunctions_.size(); }
-
-  /// addCalledFunction - Add a function to the list of functions called by this
-  /// one.
-  void addCalledFunction(DynCallGraphNode *node, unsigned count) {
-    calledFunctions_.push_back(std::make_pair(node, count));
+  typedef calledFunctionTy *iterator;
+  typedef const calledFunctionTy *const_iterator;
+
+  inline iterator begin() { return calledFunctions_; }
+  inline iterator end()   { return calledFunctions_ + numCalledFunctions_; }
+  inline const_iterator begin() const { return calledFunctions_; }
+  inline const_iterator end()   const {
+    return calledFunctions_ + numCalledFunctions_;
   }
+  inline bool empty() const { return numCalledFunctions_ == 0; }
+  inline unsigned size() const { return numCalledFunctions_; }
+
+  /// return the ID of this node within its graph file.
+  unsigned getID() const { return nodeID_; }
 
   /// return the name of the function that this call graph node represents.
-  std::string getName() const { return name_; }
+  std::string getName() const { return name_.str(); }
+
+  /// return the interned name without copying it.
+  StringRef getNameRef() const { return name_; }
 
   /// return the execution time
   double getExTime() const { return exTime_; }
 
   void setExTime(double exTime) { exTime_ = exTime; }
 
-  /// return id of this call graph node.
-  unsigned int getNum(void) const { return num_; }
+  /// return the time spent in the function itself, i.e. the execution time
+  /// without the time of the called functions. The times of the graph file
+  /// are compensated for the measuring overhead already.
+  double getSelfTime() const {
+    double selfTime = exTime_;
+    for (const_iterator it = begin(), e = end(); it != e; ++it)
+      selfTime -= it->first->getExTime();
+    return selfTime > 0.0 ? selfTime : 0.0;
+  }
+
+  /// return the statistics of the execution time over the profiled runs
+  const RunningStat &getStat() const { return stat_; }
+
+  void setStat(const RunningStat &stat) { stat_ = stat; }
+
+  /// return the call-site ID of this call graph node.
+  uint64_t getNum(void) const { return num_; }
 
   /// set instruction pointer of this node
   void setInstruction(Instruction *inst) { pInstruction_ = inst; }
@@ -85,9 +115,37 @@ public:
   Instruction *getInstruction(void) { return pInstruction_; }
 };
 
+/// A function called by a call site, summed over all calling contexts.
+struct CallTarget {
+  StringRef name;  // interned by the graph
+  uint64_t calls;
+  double exTime;
+
+  explicit CallTarget(StringRef n) : name(n), calls(0), exTime(0.0) { }
+};
+
+/// The execution times of a call site over all calling contexts it occurs in.
+/// An indirect call site has one node per context and target; its times sum
+/// up the targets of each context.
+struct CallSiteTimes {
+  DynCallGraphNode *node;  // the context with the maximum time
+  uint64_t calls;          // the number of invocations over all contexts
+  QuantileSketch times;    // the total time per context, weighted by calls
+  std::vector<CallTarget> targets;  // the called functions
+
+  explicit CallSiteTimes(DynCallGraphNode *n) : node(n), calls(0) { }
+
+  /// returns true if more than one function was called
+  bool isPolymorphic() const { return targets.size() > 1; }
+};
+
 /// The class DynCallGraph represents a control-flow-graph of a specific
 /// execution of a application. It contains entities of DynCallGraphNode class
 /// for the function nodes.
+///
+/// Nodes are stored contiguously in the order they are added and indexed by
+/// their ID. Edges are collected while reading and packed into one array per
+/// graph by finalize(), which has to be called after the last edge was added.
 class DynCallGraph {
 
   // Root is root of the call graph, or the external node if a 'main' function
@@ -95,18 +153,40 @@ class DynCallGraph {
   DynCallGraphNode *pRoot_;
 
   // the total execution time of the application
-  static double totExTime;
+  double totExTime_;
 
   // the total number of procedure calls
-  static unsigned totNoCalls;
+  unsigned totNoCalls_;
+
+  /// A directed edge that has not been packed yet.
+  struct PendingEdge {
+    unsigned parent, child, count;
+    PendingEdge(unsigned p, unsigned c, unsigned n)
+      : parent(p), child(c), count(n) { }
+  };
+
+  BumpPtrAllocator allocator_;                // nodes and call lists
+  StringMap<char, BumpPtrAllocator&> names_;  // interned function names
 
-  typedef std::map<unsigned, DynCallGraphNode*> DynFigMapTy;
-  DynFigMapTy idMap_;    // Map from a node-id to its node
-  DynFigMapTy numMap_;    // Map from the node number to its node
+  typedef std::vector<DynCallGraphNode*> DynNodeVecTy;
+  DynNodeVecTy nodes_;    // nodes in the order they were added
+  DynNodeVecTy idIndex_;  // node-id -> node (null if not present)
+  DenseMap<uint64_t, DynCallGraphNode*> sparseIndex_; // ids beyond idIndex_
+  std::vector<PendingEdge> edges_;
 
-  typedef std::map<Instruction*, DynCallGraphNode*> DynInstMapTy;
+  typedef DenseMap<uint64_t, unsigned> DynNumMapTy;
+  DynNumMapTy numMap_;   // Map from the call-site ID to its times
+  std::vector<CallSiteTimes> callSites_;
+
+  typedef DenseMap<Instruction*, DynCallGraphNode*> DynInstMapTy;
   DynInstMapTy instMap_;
 
+  DynCallGraphNode *lookupID(unsigned nodeID) const {
+    if (nodeID < idIndex_.size())
+      return idIndex_[nodeID];
+    return sparseIndex_.lookup(nodeID);
+  }
+
   DynCallGraph(const DynCallGraph&);      // DO NOT IMPLEMENT
   void operator=(const DynCallGraph&);    // DO NOT IMPLEMENT
 
@@ -114,43 +194,52 @@ public:
 
   static char ID; // Class identification, replacement for typeinfo
   static const std::string FILENAME;
-  DynCallGraph(): pRoot_(0){ }
-  ~DynCallGraph() {
-    for (DynFigMapTy::iterator it = idMap_.begin(), e = idMap_.end();
-        it != e; ++it)
-      delete it->second;
-    idMap_.clear();
-   }
+  DynCallGraph()
+    : pRoot_(0), totExTime_(0.0), totNoCalls_(0), names_(allocator_) { }
 
   //===---------------------------------------------------------------------
   // Accessors.
   //
-  typedef DynFigMapTy::iterator iterator;
-  typedef DynFigMapTy::const_iterator const_iterator;
+  typedef DynNodeVecTy::iterator iterator;
+  typedef DynNodeVecTy::const_iterator const_iterator;
 
-  inline       iterator begin()       { return idMap_.begin(); }
-  inline       iterator end()         { return idMap_.end();   }
-  inline const_iterator begin() const { return idMap_.begin(); }
-  inline const_iterator end()   const { return idMap_.end();   }
+  inline       iterator begin()       { return nodes_.begin(); }
+  inline       iterator end()         { return nodes_.end();   }
+  inline const_iterator begin() const { return nodes_.begin(); }
+  inline const_iterator end()   const { return nodes_.end();   }
+  inline unsigned size() const { return (unsigned)nodes_.size(); }
 
 
   typedef DynInstMapTy::iterator instr_iterator;
   inline       instr_iterator instr_begin()       { return instMap_.begin(); }
   inline       instr_iterator instr_end()         { return instMap_.end();   }
 
-  // addNode - adds a function with a given ID to the callgraph.
+  // addNode - adds a function with a given ID to the callgraph. The
+  // statistics describe exTime over several runs; a single run is assumed if
+  // they are empty.
   //
-  DynCallGraphNode* addNode(unsigned nodeID, std::string node,
-                            unsigned num, double exTime);
+  DynCallGraphNode* addNode(unsigned nodeID, StringRef node,
+                            uint64_t num, double exTime,
+                            const RunningStat &stat = RunningStat());
 
   // addEdge - adds an directed edge between two nodes.
   bool addEdge(unsigned parentID, unsigned nodeID, unsigned count);
 
+  // finalize - packs the edges added so far into the call lists of the nodes.
+  void finalize();
+
   /// get root node
   DynCallGraphNode* getRoot() const { return pRoot_; }
 
+  /// get node with the given id or null
+  DynCallGraphNode* getNode(unsigned nodeID) const { return lookupID(nodeID); }
+
   /// create a link between a node and an instruction
-  bool linkInstruction(unsigned num, Instruction* inst);
+  bool linkInstruction(uint64_t num, Instruction* inst);
+
+  /// link the nodes of all call sites of the table to their instructions;
+  /// returns the number of linked call sites
+  unsigned linkInstructions(const CallSiteTable &table);
 
   /// resolve the name of the concrete function of a given call(inv) instruction
   bool getConcreteName(Instruction*, std::string&) const;
@@ -158,17 +247,44 @@ public:
   /// get execution time of given call- (invoke-) instruction
   double getExecutionTime(Instruction*) const;
 
+  /// get the q-quantile of the execution times of the contexts of given call-
+  /// (invoke-) instruction; q == 1 yields the maximum
+  double getExecutionTime(Instruction*, double q) const;
+
+  /// get the maximum time of given call- (invoke-) instruction over its
+  /// contexts, summed over the targets of each context; it bounds every
+  /// quantile of the execution time
+  double getMaxContextTime(Instruction*) const;
+
+  /// get the 95% confidence bounds of the execution time of given call-
+  /// (invoke-) instruction
+  void getExecutionTimeBounds(Instruction*, double &lo, double &hi) const;
+
+  /// get the 95% confidence bounds of the q-quantile of the execution times
+  void getExecutionTimeBounds(Instruction*, double q, double &lo,
+                              double &hi) const;
+
+  /// get the execution times of a call site over its contexts or null
+  const CallSiteTimes *getCallSiteTimes(Instruction*) const;
+
+  /// get the execution times of the call site with the given ID or null
+  const CallSiteTimes *getCallSiteTimes(uint64_t num) const;
+
+  /// return the number of bytes allocated for the graph
+  size_t getMemoryUsage() const;
+
   /// return the total number of calls
-  unsigned getTotNoCalls() const { return totNoCalls; }
+  unsigned getTotNoCalls() const { return totNoCalls_; }
 
   /// increments the total number of calls by val
-  void incTotNoCalls(unsigned val) { totNoCalls += val; }
+  void incTotNoCalls(unsigned val) { totNoCalls_ += val; }
 
-    /// return the total execution time of the application
-  static double getTotExecutionTime(void) { return totExTime; }
+  /// return the total execution time of the application, i.e. the time of
+  /// the root node
+  double getTotExecutionTime(void) const { return totExTime_; }
 
-  /// return the total execution time of the application
-  void setTotExecutionTime(double time) { totExTime = time; }
+  /// set the total execution time of the application
+  void setTotExecutionTime(double time) { totExTime_ = time; }
 };
 }
 
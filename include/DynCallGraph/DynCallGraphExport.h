@@ -0,0 +1,52 @@
+//===-- DynCallGraph/DynCallGraphExport.h - Graph export - Interface ------===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares functions that export a dynamic call graph: the graph
+// file format itself, the folded-stack format read by flame-graph tools and a
+// report of the functions with the highest self time.
+//
+//===----------------------------------------------------------------------===//
+#ifndef PARPOT_DYNCALLGRAPH_DYNCALLGRAPHEXPORT_H_
+#define PARPOT_DYNCALLGRAPH_DYNCALLGRAPHEXPORT_H_
+
+#include "DynCallGraph/DynCallGraph.h"
+#include "llvm/ADT/StringRef.h"
+#include <vector>
+
+namespace llvm {
+
+  class raw_ostream;
+
+  /// The self time of a function summed over its calling contexts.
+  struct SelfTimeEntry {
+    StringRef name;     // interned by the graph
+    double selfTime;
+    unsigned contexts;  // the number of calling contexts
+
+    SelfTimeEntry(StringRef n) : name(n), selfTime(0.0), contexts(0) { }
+  };
+
+  /// writes the graph in the format of the graph files, so it can be read
+  /// again. The nodes are written in preorder like the runtime does; each
+  /// label is extended by the weight and the squared deviations of the runs.
+  void writeDynCallGraph(const DynCallGraph &graph, raw_ostream &out);
+
+  /// writes one line per calling context with a self time, i.e. the function
+  /// names from the root down to the context separated by ';' followed by the
+  /// rounded self time. The graph is traversed without recursion.
+  void writeFoldedStacks(const DynCallGraph &graph, raw_ostream &out);
+
+  /// collects the n functions with the highest self time (n == 0: all) in
+  /// descending order.
+  void getTopSelfTimes(const DynCallGraph &graph, unsigned n,
+                       std::vector<SelfTimeEntry> &entries);
+
+  /// prints the n functions with the highest self time (n == 0: all).
+  void printTopSelfTimes(const DynCallGraph &graph, unsigned n,
+                         raw_ostream &out);
+}
+
+#endif /* PARPOT_DYNCALLGRAPH_DYNCALLGRAPHEXPORT_H_ */
@@ -6,7 +6,9 @@
 //
 // This file declares the DynCallGraphParserPass class. It is used to read data
 // from a dynamic call graph file (.dot format). The class is derived from
-// DynCallGraph which is also an interface to obtain the data.
+// DynCallGraph which is also an interface to obtain the data. Several files
+// (-dcg-file, -dcg-dir) are merged into one graph. Further graphs can be read
+// without the pass by readDynCallGraph().
 //
 //===----------------------------------------------------------------------===//
 #ifndef PARPOT_DYNCALLGRAPH_DYNCALLGRAPHPARSERPASS_H_
@@ -17,6 +19,7 @@
 #include "DynCallGraph/DynCallGraph.h"
 #include <vector>
 #include <map>
+#include <string>
 
 namespace llvm {
 
@@ -31,10 +34,27 @@ namespace llvm {
 			AU.setPreservesAll();
 		}
 		virtual bool runOnModule(Module &M);
-
-	private:
-		bool fillGraph(const char *filename);
 	};
+
+  /// reads a dynamic call graph file into graph, which is finalized
+  /// afterwards. Several graphs may be read side by side this way. Subtrees
+  /// whose inclusive time is below minFraction of the total time are skipped.
+  bool readDynCallGraph(const std::string &filename, DynCallGraph &graph,
+                        double minFraction = 0.0);
+
+  /// reads several dynamic call graph files in parallel (threads == 0: one
+  /// thread per processor) and merges their calling contexts into graph. The
+  /// minimum fraction applies to each file on its own.
+  bool readDynCallGraphs(const std::vector<std::string> &filenames,
+                         DynCallGraph &graph, unsigned threads = 0,
+                         double minFraction = 0.0);
+
+  /// like above, but the times and call counts of each file are scaled by
+  /// its weight, e.g. the weight of the profiling run that wrote it.
+  bool readDynCallGraphs(const std::vector<std::string> &filenames,
+                         const std::vector<double> &weights,
+                         DynCallGraph &graph, unsigned threads = 0,
+                         double minFraction = 0.0);
 }
 
 
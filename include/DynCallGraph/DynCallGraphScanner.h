@@ -0,0 +1,221 @@
+//===- DynCallGraph/DynCallGraphScanner.h - DOT record scanner - Interface ===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the DynCallGraphScanner class. It reads the node and edge
+// records of a dynamic call graph file (.dot format written by the runtime) in
+// place, i.e. without copying lines or allocating memory:
+//
+//   \tNode<id> [shape=record,label="{<name>;<num>;<time>[;<weight>;<m2>]}"];
+//   \tNode<parent> -> Node<child> [label="<count>"];
+//
+// All other lines are skipped.
+//
+//===----------------------------------------------------------------------===//
+#ifndef PARPOT_DYNCALLGRAPH_DYNCALLGRAPHSCANNER_H
+#define PARPOT_DYNCALLGRAPH_DYNCALLGRAPHSCANNER_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace llvm {
+
+  /// The DynCallGraphScanner class scans the records of a dynamic call graph
+  /// held in memory (usually a memory mapped file).
+  class DynCallGraphScanner {
+  public:
+    enum RecordKind { NodeRecord, EdgeRecord, ErrorRecord, EndOfFile };
+
+    /// A node record; name points into the scanned buffer.
+    struct Node {
+      unsigned id;
+      StringRef name;
+      uint64_t num;
+      double exTime;
+      double weight;  // weight of the runs (merged graphs) or 0
+      double m2;      // squared deviations of the runs (merged graphs) or 0
+    };
+
+    /// An edge record.
+    struct Edge {
+      unsigned parent;
+      unsigned child;
+      unsigned count;
+    };
+
+  private:
+    const char *pos_, *end_;
+    unsigned line_;
+
+    // helpers parsing a single token at pos; they return false on a mismatch
+    static bool parseUnsigned(const char *&pos, const char *end, uint64_t &val);
+    static bool parseDouble(const char *&pos, const char *end, double &val);
+    static bool skip(const char *&pos, const char *end, const char *str);
+    static bool find(const char *&pos, const char *end, char c);
+
+    bool parseNode(const char *pos, const char *end, Node &node);
+    bool parseEdge(const char *pos, const char *end, Edge &edge);
+
+  public:
+    DynCallGraphScanner(const char *begin, const char *end)
+      : pos_(begin), end_(end), line_(0) { }
+
+    /// reads the next record and returns its kind.
+    RecordKind next(Node &node, Edge &edge);
+
+    /// returns the number of the line read last (starting at 1)
+    unsigned getLine() const { return line_; }
+  };
+
+  inline bool DynCallGraphScanner::parseUnsigned(const char *&pos,
+                                                 const char *end,
+                                                 uint64_t &val) {
+    if (pos == end || *pos < '0' || *pos > '9')
+      return false;
+    val = 0;
+    while (pos != end && *pos >= '0' && *pos <= '9')
+      val = val * 10 + (*pos++ - '0');
+    return true;
+  }
+
+  inline bool DynCallGraphScanner::parseDouble(const char *&pos,
+                                               const char *end, double &val) {
+    static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+                                    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14,
+                                    1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21,
+                                    1e22 };
+    bool negative = false;
+    if (pos != end && (*pos == '-' || *pos == '+'))
+      negative = *pos++ == '-';
+
+    // collect up to 19 significant digits; the remaining ones only scale
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any = false;
+    for (; pos != end && *pos >= '0' && *pos <= '9'; ++pos, any = true) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*pos - '0');
+        if (mantissa) ++digits;
+      } else
+        ++exponent;
+    }
+    if (pos != end && *pos == '.') {
+      for (++pos; pos != end && *pos >= '0' && *pos <= '9'; ++pos, any = true)
+        if (digits < 19) {
+          mantissa = mantissa * 10 + (*pos - '0');
+          if (mantissa) ++digits;
+          --exponent;
+        }
+    }
+    if (!any)
+      return false;
+
+    if (pos != end && (*pos == 'e' || *pos == 'E')) {
+      const char *exp = pos + 1;
+      bool negExp = false;
+      if (exp != end && (*exp == '-' || *exp == '+'))
+        negExp = *exp++ == '-';
+      uint64_t e;
+      if (parseUnsigned(exp, end, e)) {
+        exponent += negExp ? -(int)e : (int)e;
+        pos = exp;
+      }
+    }
+
+    val = (double)mantissa;
+    if (exponent < 0)
+      val = -exponent <= 22 ? val / pow10[-exponent]
+                            : val * std::pow(10.0, exponent);
+    else if (exponent > 0)
+      val = exponent <= 22 ? val * pow10[exponent]
+                           : val * std::pow(10.0, exponent);
+    if (negative)
+      val = -val;
+    return true;
+  }
+
+  inline bool DynCallGraphScanner::skip(const char *&pos, const char *end,
+                                        const char *str) {
+    size_t len = strlen(str);
+    if ((size_t)(end - pos) < len || memcmp(pos, str, len) != 0)
+      return false;
+    pos += len;
+    return true;
+  }
+
+  inline bool DynCallGraphScanner::find(const char *&pos, const char *end,
+                                        char c) {
+    const char *found = (const char*)memchr(pos, c, end - pos);
+    if (!found)
+      return false;
+    pos = found + 1;
+    return true;
+  }
+
+  inline bool DynCallGraphScanner::parseNode(const char *pos, const char *end,
+                                             Node &node) {
+    // name
+    if (!find(pos, end, '{'))
+      return false;
+    const char *name = pos;
+    if (!find(pos, end, ';'))
+      return false;
+    node.name = StringRef(name, pos - name - 1);
+
+    // number and execution time
+    if (!parseUnsigned(pos, end, node.num) || !skip(pos, end, ";") ||
+        !parseDouble(pos, end, node.exTime))
+      return false;
+
+    // optional statistics of merged graphs
+    node.weight = node.m2 = 0.0;
+    if (skip(pos, end, ";") &&
+        !(parseDouble(pos, end, node.weight) && skip(pos, end, ";") &&
+          parseDouble(pos, end, node.m2)))
+      return false;
+    return skip(pos, end, "}");
+  }
+
+  inline bool DynCallGraphScanner::parseEdge(const char *pos, const char *end,
+                                             Edge &edge) {
+    uint64_t child, count;
+    if (!skip(pos, end, "Node") || !parseUnsigned(pos, end, child) ||
+        !skip(pos, end, " [label=\"") || !parseUnsigned(pos, end, count))
+      return false;
+    edge.child = (unsigned)child;
+    edge.count = (unsigned)count;
+    return true;
+  }
+
+  inline DynCallGraphScanner::RecordKind
+  DynCallGraphScanner::next(Node &node, Edge &edge) {
+    while (pos_ != end_) {
+      // determine the current line
+      const char *begin = pos_;
+      const char *eol = (const char*)memchr(begin, '\n', end_ - begin);
+      if (!eol) eol = end_;
+      pos_ = eol == end_ ? end_ : eol + 1;
+      ++line_;
+
+      const char *pos = begin;
+      uint64_t id;
+      if (!skip(pos, eol, "\tNode") || !parseUnsigned(pos, eol, id))
+        continue; // no record
+
+      if (skip(pos, eol, " -> ")) {
+        edge.parent = (unsigned)id;
+        return parseEdge(pos, eol, edge) ? EdgeRecord : ErrorRecord;
+      }
+      node.id = (unsigned)id;
+      return parseNode(pos, eol, node) ? NodeRecord : ErrorRecord;
+    }
+    return EndOfFile;
+  }
+}
+
+#endif
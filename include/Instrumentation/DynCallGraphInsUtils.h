@@ -15,6 +15,7 @@
 
 #include "llvm/BasicBlock.h"
 #include "llvm/Support/CallSite.h"
+#include "llvm/Support/DataTypes.h"
 
 namespace llvm {
   class Function;
@@ -36,9 +37,9 @@ namespace llvm {
 
   /// adds a call to a given library function (fnName) which indicates an
   /// upcoming call instruction. This is an important step to build a dynamic
-  /// call graph.
+  /// call graph. fnNum is the ID of the call site (see CallSiteID.h).
   void addNotifyCall(CallSite *cs, BasicBlock *bb, const char *fnNameBefore,
-      const char *fnNameAfter, GlobalVariable *gv, unsigned fnNum);
+      const char *fnNameAfter, GlobalVariable *gv, uint64_t fnNum);
 
   /// adds a call to a given library function (fnName) that register a called
   /// function in order to build a dynamic call graph.
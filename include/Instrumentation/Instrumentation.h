@@ -19,6 +19,12 @@ class ModulePass;
 // Insert edge profiling instrumentation
 ModulePass *createFTimeProfilerPass();
 
+// Insert loop time profiling instrumentation
+ModulePass *createLTimeProfilerPass();
+
+// Assign module-qualified IDs to call sites
+ModulePass *createCallSiteIDPass();
+
 // Insert dynamic call graph instrumentation
 ModulePass *createDynCallGraphPass();
 
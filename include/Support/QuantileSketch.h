@@ -0,0 +1,99 @@
+//===----- Support/QuantileSketch.h - Streaming quantiles - Interface -----===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the QuantileSketch class, which estimates quantiles of a
+// stream of non-negative samples with a bounded relative error.
+//
+//===----------------------------------------------------------------------===//
+#ifndef PARPOT_SUPPORT_QUANTILESKETCH_H
+#define PARPOT_SUPPORT_QUANTILESKETCH_H
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace llvm {
+
+  /// The QuantileSketch class sorts samples into logarithmic buckets, so each
+  /// quantile is known up to the relative accuracy given at construction
+  /// (1% by default). Counts, sum, minimum and maximum are exact. Sketches
+  /// with equal accuracy can be merged.
+  class QuantileSketch {
+    double gamma_;                  // ratio of the bucket bounds
+    double logGamma_;
+    std::map<int, double> buckets_; // bucket index -> weight
+    double zeroWeight_;             // weight of samples <= 0
+    double weight_, sum_, min_, max_;
+
+    int getBucket(double x) const {
+      return (int)std::ceil(std::log(x) / logGamma_);
+    }
+
+  public:
+    explicit QuantileSketch(double accuracy = 0.01)
+      : gamma_((1.0 + accuracy) / (1.0 - accuracy)),
+        logGamma_(std::log(gamma_)), zeroWeight_(0.0), weight_(0.0),
+        sum_(0.0), min_(0.0), max_(0.0) { }
+
+    /// adds a sample with the given weight.
+    void add(double x, double w = 1.0) {
+      if (w <= 0.0) return;
+      if (x > 0.0)
+        buckets_[getBucket(x)] += w;
+      else
+        zeroWeight_ += w;
+      min_ = weight_ > 0.0 ? std::min(min_, x) : x;
+      max_ = weight_ > 0.0 ? std::max(max_, x) : x;
+      weight_ += w;
+      sum_ += w * x;
+    }
+
+    /// merges the samples of another sketch into this one.
+    void merge(const QuantileSketch &rhs) {
+      if (rhs.weight_ <= 0.0) return;
+      for (std::map<int, double>::const_iterator it = rhs.buckets_.begin(),
+            e = rhs.buckets_.end(); it != e; ++it)
+        buckets_[it->first] += it->second;
+      min_ = weight_ > 0.0 ? std::min(min_, rhs.min_) : rhs.min_;
+      max_ = weight_ > 0.0 ? std::max(max_, rhs.max_) : rhs.max_;
+      zeroWeight_ += rhs.zeroWeight_;
+      weight_ += rhs.weight_;
+      sum_ += rhs.sum_;
+    }
+
+    bool empty() const { return weight_ <= 0.0; }
+    double getWeight() const { return weight_; }
+    double getSum() const { return sum_; }
+    double getMin() const { return min_; }
+    double getMax() const { return max_; }
+    double getMean() const { return weight_ > 0.0 ? sum_ / weight_ : 0.0; }
+
+    /// returns the estimated q-quantile (0 <= q <= 1); 0 and 1 yield the
+    /// exact minimum and maximum.
+    double getQuantile(double q) const {
+      if (weight_ <= 0.0) return 0.0;
+      if (q <= 0.0) return min_;
+      if (q >= 1.0) return max_;
+
+      double rank = q * weight_;
+      double seen = zeroWeight_;
+      if (rank <= seen)
+        return std::max(min_, 0.0);
+      for (std::map<int, double>::const_iterator it = buckets_.begin(),
+            e = buckets_.end(); it != e; ++it) {
+        seen += it->second;
+        if (rank <= seen) {
+          // the center of the bucket in terms of relative error
+          double x = 2.0 * std::pow(gamma_, it->first) / (gamma_ + 1.0);
+          return std::min(std::max(x, min_), max_);
+        }
+      }
+      return max_;
+    }
+  };
+}
+
+#endif
@@ -0,0 +1,94 @@
+//===------- Support/RunningStat.h - Streaming statistics - Interface -----===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the RunningStat class. It keeps the weighted mean and
+// variance of a series of samples (e.g. the timings of several profiling runs)
+// without storing the samples themselves.
+//
+//===----------------------------------------------------------------------===//
+#ifndef PARPOT_SUPPORT_RUNNINGSTAT_H
+#define PARPOT_SUPPORT_RUNNINGSTAT_H
+
+#include <cmath>
+
+namespace llvm {
+
+  /// The RunningStat class computes mean and variance of weighted samples in
+  /// a single pass (West's algorithm). Weights are frequency weights, i.e. a
+  /// sample of weight 2 counts like two equal samples. Two statistics can be
+  /// merged, so partial results of several files or threads may be combined.
+  class RunningStat {
+    double weight_; // sum of the sample weights
+    double mean_;
+    double m2_;     // weighted sum of squared deviations from the mean
+
+  public:
+    RunningStat(): weight_(0.0), mean_(0.0), m2_(0.0) { }
+    RunningStat(double weight, double mean, double m2)
+      : weight_(weight), mean_(mean), m2_(m2) { }
+
+    /// adds a sample with the given weight.
+    void add(double x, double w = 1.0) {
+      if (w <= 0.0) return;
+      double total = weight_ + w;
+      double delta = x - mean_;
+      double r = delta * w / total;
+      mean_ += r;
+      m2_ += weight_ * delta * r;
+      weight_ = total;
+    }
+
+    /// merges the samples of another statistic into this one.
+    void merge(const RunningStat &rhs) {
+      if (rhs.weight_ <= 0.0) return;
+      if (weight_ <= 0.0) { *this = rhs; return; }
+      double total = weight_ + rhs.weight_;
+      double delta = rhs.mean_ - mean_;
+      mean_ += delta * rhs.weight_ / total;
+      m2_ += rhs.m2_ + delta * delta * weight_ * rhs.weight_ / total;
+      weight_ = total;
+    }
+
+    /// scales all samples by the given factor.
+    void scale(double factor) {
+      mean_ *= factor;
+      m2_ *= factor * factor;
+    }
+
+    bool empty() const { return weight_ <= 0.0; }
+    double getWeight() const { return weight_; }
+    double getMean() const { return mean_; }
+    double getM2() const { return m2_; }
+
+    /// returns the sample variance (0 for less than two samples).
+    double getVariance() const {
+      return weight_ > 1.0 ? m2_ / (weight_ - 1.0) : 0.0;
+    }
+
+    /// returns the half width of the 95% confidence interval of the mean.
+    double getHalfWidth() const {
+      if (weight_ <= 1.0) return 0.0;
+      return getT95(weight_ - 1.0) * std::sqrt(getVariance() / weight_);
+    }
+
+    /// returns the half width of the 95% confidence interval relative to the
+    /// mean.
+    double getRelHalfWidth() const {
+      return mean_ != 0.0 ? getHalfWidth() / std::fabs(mean_) : 0.0;
+    }
+
+    /// returns the two-sided 95% quantile of Student's t-distribution.
+    static double getT95(double df) {
+      static const double table[] = { 12.706, 4.303, 3.182, 2.776, 2.571,
+                                      2.447, 2.365, 2.306, 2.262, 2.228 };
+      if (df < 1.0) return table[0];
+      if (df <= 10.0) return table[(unsigned)df - 1];
+      return 1.96 + 2.4 / df; // close approximation for larger df
+    }
+  };
+}
+
+#endif
@@ -0,0 +1,108 @@
+//===--------- Support/ThreadPool.h - Parallel task execution - Interface -===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the ThreadPool class, which runs independent work items
+// of a ParallelTask on several threads.
+//
+//===----------------------------------------------------------------------===//
+#ifndef PARPOT_SUPPORT_THREADPOOL_H
+#define PARPOT_SUPPORT_THREADPOOL_H
+
+#include "llvm/Support/Atomic.h"
+
+#include <algorithm>
+#include <pthread.h>
+#include <unistd.h>
+#include <vector>
+
+namespace llvm {
+
+  /// A ParallelTask consists of numbered work items that may run
+  /// concurrently. run() must only touch data of its own item or data of
+  /// its worker.
+  class ParallelTask {
+  public:
+    virtual ~ParallelTask() { }
+
+    /// processes the work item with the given index on the given worker
+    /// (0 <= worker < ThreadPool::getNumThreads())
+    virtual void run(unsigned item, unsigned worker) = 0;
+  };
+
+  /// An ItemTask is a ParallelTask without state per worker.
+  class ItemTask : public ParallelTask {
+  public:
+    /// processes the work item with the given index
+    virtual void runItem(unsigned item) = 0;
+
+    virtual void run(unsigned item, unsigned) { runItem(item); }
+  };
+
+  /// The ThreadPool class runs the items of a task on a fixed number of
+  /// threads. Every thread takes the next unprocessed item until all items
+  /// are done; the calling thread takes part as well.
+  class ThreadPool {
+    unsigned numThreads_;
+
+    ThreadPool(const ThreadPool&);        // DO NOT IMPLEMENT
+    void operator=(const ThreadPool&);    // DO NOT IMPLEMENT
+
+    struct Job {
+      ParallelTask *task;
+      unsigned numItems;
+      volatile sys::cas_flag next;
+      volatile sys::cas_flag nextWorker;
+    };
+
+    static void *work(void *arg) {
+      Job *job = static_cast<Job*>(arg);
+      unsigned worker = (unsigned)sys::AtomicIncrement(&job->nextWorker) - 1;
+      for (;;) {
+        unsigned item = (unsigned)sys::AtomicIncrement(&job->next) - 1;
+        if (item >= job->numItems)
+          break;
+        job->task->run(item, worker);
+      }
+      return 0;
+    }
+
+  public:
+    /// creates a pool of the given number of threads; 0 means one thread per
+    /// online processor.
+    explicit ThreadPool(unsigned numThreads = 0) : numThreads_(numThreads) {
+      if (!numThreads_) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        numThreads_ = cpus > 0 ? (unsigned)cpus : 1;
+      }
+    }
+
+    unsigned getNumThreads() const { return numThreads_; }
+
+    /// runs task.run(i) for all i in [0, numItems) and waits for completion.
+    void run(ParallelTask &task, unsigned numItems) {
+      Job job;
+      job.task = &task;
+      job.numItems = numItems;
+      job.next = 0;
+      job.nextWorker = 0;
+
+      // start helper threads; fall back to fewer threads if creation fails
+      unsigned helpers = std::min(numThreads_, numItems);
+      std::vector<pthread_t> threads;
+      for (unsigned i = 1; i < helpers; ++i) {
+        pthread_t thread;
+        if (pthread_create(&thread, 0, work, &job) == 0)
+          threads.push_back(thread);
+      }
+
+      work(&job);
+      for (unsigned i = 0, e = threads.size(); i != e; ++i)
+        pthread_join(threads[i], 0);
+    }
+  };
+}
+
+#endif
@@ -9,9 +9,52 @@
 //===----------------------------------------------------------------------===//
 
 #include "Analysis/AnalysisContext.h"
+#include "Analysis/ModRefSummary.h"
+
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/PostDominators.h"
 
 using namespace llvm;
 
+AnalysisContext::~AnalysisContext() {
+  DeleteContainerSeconds(dsgLocks_);
+  DeleteContainerSeconds(domTrees_);
+  DeleteContainerSeconds(postDomTrees_);
+}
+
+void AnalysisContext::computeModRefSummary(void) {
+  modRef_.reset(new ModRefSummary(*this));
+}
+
+void AnalysisContext::computeDominators(Function &F) {
+  DominatorTree *&domTree = domTrees_[&F];
+  if (domTree)
+    return;
+
+  // with valid DFS numbers, queries don't modify the trees anymore, so
+  // analyses of several threads may share them
+  domTree = new DominatorTree();
+  domTree->runOnFunction(F);
+  domTree->DT->updateDFSNumbers();
+
+  PostDominatorTree *postDomTree = new PostDominatorTree();
+  postDomTree->runOnFunction(F);
+  postDomTree->DT->updateDFSNumbers();
+  postDomTrees_[&F] = postDomTree;
+}
+
+DominatorTree* AnalysisContext::getDomTree(const Function &F) const {
+  std::map<const Function*, DominatorTree*>::const_iterator it =
+    domTrees_.find(&F);
+  return it != domTrees_.end() ? it->second : 0;
+}
+
+PostDominatorTree* AnalysisContext::getPostDomTree(const Function &F) const {
+  std::map<const Function*, PostDominatorTree*>::const_iterator it =
+    postDomTrees_.find(&F);
+  return it != postDomTrees_.end() ? it->second : 0;
+}
+
 Function* AnalysisContext::getFunctionPtr(const CallSite &cs) const {
 
   Function *f = cs.getCalledFunction();
@@ -20,17 +63,87 @@ Function* AnalysisContext::getFunctionPtr(const CallSite &cs) const {
   else if (f)
     return f;
 
+  // indirect calls are resolved once per dynamic call graph
+  sys::ScopedLock guard(lock_);
+  std::pair<DenseMap<Instruction*, Function*>::iterator, bool> cached =
+    funcCache_.insert(std::make_pair(cs.getInstruction(), (Function*)NULL));
+  if (!cached.second)
+    return cached.first->second;
+
   std::string concrete;
   if (!pDCG_->getConcreteName(cs.getInstruction(), concrete))
     return NULL; // no function ptr. found
 
+  f = lookupCallee(concrete);
+  funcCache_[cs.getInstruction()] = f;
+  return f;
+}
+
+bool AnalysisContext::getCallees(const CallSite &cs,
+                                 CalleeVecTy &callees) const {
+  if (cs.getCalledFunction())
+    return getCallees(cs, callees, *pDCG_);
+
+  // indirect calls are resolved once per dynamic call graph
+  sys::ScopedLock guard(lock_);
+  DenseMap<Instruction*, CalleeVecTy>::const_iterator cached =
+    calleeCache_.find(cs.getInstruction());
+  if (cached != calleeCache_.end()) {
+    callees = cached->second;
+    return !callees.empty();
+  }
+
+  getCallees(cs, callees, *pDCG_);
+  calleeCache_[cs.getInstruction()] = callees;
+  return !callees.empty();
+}
+
+bool AnalysisContext::getCallees(const CallSite &cs, CalleeVecTy &callees,
+                                 const DynCallGraph &dcg) const {
+  callees.clear();
+
+  Function *f = cs.getCalledFunction();
+  if (f) {
+    if (!f->isDeclaration())
+      callees.push_back(std::make_pair(f, 1.0));
+    return !callees.empty();
+  }
+
+  // weight the targets of an indirect call by their number of calls
+  const CallSiteTimes *site = dcg.getCallSiteTimes(cs.getInstruction());
+  if (site && site->calls)
+    for (std::vector<CallTarget>::const_iterator it = site->targets.begin(),
+          e = site->targets.end(); it != e; ++it)
+      if (Function *target = lookupCallee(it->name))
+        callees.push_back(std::make_pair(target,
+                                         (double)it->calls / site->calls));
+  return !callees.empty();
+}
+
+void AnalysisContext::buildCalleeIndex(void) {
+  if (!pCG_)
+    return;
+
   CallGraphNode *cgNode = pCG_->getExternalCallingNode();
   for (CallGraphNode::iterator iCGN = cgNode->begin(),
         eCGN = cgNode->end(); iCGN != eCGN; ++iCGN) {
-    if (iCGN->second->getFunction()->getName().str() == concrete) {
-      return iCGN->second->getFunction();
-    }
+    Function *f = iCGN->second->getFunction();
+    if (f)
+      calleeIndex_.GetOrCreateValue(f->getName(), f);
   }
+}
+
+Function* AnalysisContext::lookupCallee(StringRef name) const {
+  StringMap<Function*>::const_iterator it = calleeIndex_.find(name);
+  return it != calleeIndex_.end() ? it->second : NULL; // no function ptr. found
+}
 
-  return NULL; // no function ptr. found
+DSGraph* AnalysisContext::getDSGraph(const Function &F, sys::Mutex *&lock) {
+  sys::ScopedLock guard(lock_);
+  DSGraph *graph = pDSA_->getDSGraph(F);
+  sys::Mutex *&graphLock = dsgLocks_[graph];
+  if (!graphLock)
+    graphLock = new sys::Mutex();
+  lock = graphLock;
+  return graph;
 }
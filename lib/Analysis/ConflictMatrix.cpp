@@ -0,0 +1,167 @@
+//======= ConflictMatrix.cpp - Call-site conflicts - Implementation ==========//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the conflict matrix of the call sites of a function.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Analysis/ConflictMatrix.h"
+
+#include "llvm/GlobalVariable.h"
+#include "llvm/Support/MathExtras.h"
+
+#include <algorithm>
+
+using namespace llvm;
+
+void ConflictMatrix::clear(void) {
+  sites_.clear();
+  accesses_.clear();
+  nodeNums_.clear();
+  globalNums_.clear();
+  objectGlobals_.clear();
+  numWords_ = 0;
+}
+
+unsigned ConflictMatrix::addSite(Instruction *I) {
+  sites_.push_back(I);
+  accesses_.push_back(AccessVecTy());
+  return sites_.size() - 1;
+}
+
+void ConflictMatrix::addNode(unsigned site, const DSNode *node,
+                             ArgModRefResult modRef, StringRef name) {
+  std::pair<DenseMap<const DSNode*, unsigned>::iterator, bool> num =
+    nodeNums_.insert(std::make_pair(node, (unsigned)objectGlobals_.size()));
+  if (num.second)
+    objectGlobals_.push_back(-1);
+  accesses_[site].push_back(Access(num.first->second, modRef, name));
+}
+
+unsigned ConflictMatrix::getGlobalObject(unsigned global) {
+  std::pair<DenseMap<unsigned, unsigned>::iterator, bool> num =
+    globalNums_.insert(std::make_pair(global, (unsigned)objectGlobals_.size()));
+  if (num.second)
+    objectGlobals_.push_back(global);
+  return num.first->second;
+}
+
+void ConflictMatrix::addGlobals(unsigned site, const BitVector &reads,
+                                const BitVector &writes) {
+  AccessVecTy &accesses = accesses_[site];
+  for (int i = reads.find_first(); i != -1; i = reads.find_next(i))
+    accesses.push_back(Access(getGlobalObject(i), Ref, ""));
+  for (int i = writes.find_first(); i != -1; i = writes.find_next(i))
+    accesses.push_back(Access(getGlobalObject(i), Mod, ""));
+}
+
+void ConflictMatrix::buildRows(void) {
+  numWords_ = (objectGlobals_.size() + 63) / 64;
+  reads_.assign(sites_.size() * numWords_, 0);
+  writes_.assign(sites_.size() * numWords_, 0);
+
+  for (unsigned site = 0, e = sites_.size(); site != e; ++site) {
+    AccessVecTy &accesses = accesses_[site];
+
+    // merge the accesses to the same object; the first name is kept
+    std::stable_sort(accesses.begin(), accesses.end());
+    AccessVecTy::iterator out = accesses.begin();
+    for (AccessVecTy::iterator it = accesses.begin(), eA = accesses.end();
+         it != eA; ++it) {
+      if (out != accesses.begin() && (out - 1)->object == it->object)
+        (out - 1)->modRef |= it->modRef;
+      else
+        *out++ = *it;
+    }
+    accesses.erase(out, accesses.end());
+
+    uint64_t *reads = &reads_[site * numWords_];
+    uint64_t *writes = &writes_[site * numWords_];
+    for (AccessVecTy::const_iterator it = accesses.begin(),
+          eA = accesses.end(); it != eA; ++it) {
+      uint64_t bit = 1ULL << (it->object % 64);
+      if (it->modRef & Ref)
+        reads[it->object / 64] |= bit;
+      if (it->modRef & Mod)
+        writes[it->object / 64] |= bit;
+    }
+  }
+}
+
+const ConflictMatrix::Access &ConflictMatrix::getAccess(unsigned site,
+                                                        unsigned object) const {
+  const AccessVecTy &accesses = accesses_[site];
+  AccessVecTy::const_iterator it =
+    std::lower_bound(accesses.begin(), accesses.end(),
+                     Access(object, NoModRef, ""));
+  assert(it != accesses.end() && it->object == object && "No access!");
+  return *it;
+}
+
+void ConflictMatrix::addDependences(DepGraph *dg, unsigned firstNew) {
+  buildRows();
+
+  for (unsigned a = 0, e = sites_.size(); a != e; ++a) {
+    const uint64_t *readsA = &reads_[a * numWords_];
+    const uint64_t *writesA = &writes_[a * numWords_];
+    for (unsigned b = std::max(a + 1, firstNew); b < e; ++b) {
+      const uint64_t *readsB = &reads_[b * numWords_];
+      const uint64_t *writesB = &writes_[b * numWords_];
+
+      for (unsigned w = 0; w != numWords_; ++w) {
+        uint64_t trueDeps = writesA[w] & readsB[w];
+        uint64_t antiDeps = readsA[w] & writesB[w];
+        uint64_t outputDeps = writesA[w] & writesB[w];
+        uint64_t conflicts = trueDeps | antiDeps | outputDeps;
+        while (conflicts) {
+          unsigned bit = CountTrailingZeros_64(conflicts);
+          conflicts &= conflicts - 1;
+          addConflict(dg, a, b, w * 64 + bit, (trueDeps >> bit) & 1,
+                      (antiDeps >> bit) & 1, (outputDeps >> bit) & 1);
+        }
+      }
+    }
+  }
+}
+
+void ConflictMatrix::addConflict(DepGraph *dg, unsigned a, unsigned b,
+                                 unsigned object, bool trueDep,
+                                 bool antiDep, bool outputDep) const {
+  Instruction *iA = sites_[a], *iB = sites_[b];
+
+  // globals: a change on both sides is an output dependence, otherwise the
+  // read-only side decides the direction
+  if (objectGlobals_[object] >= 0) {
+    GlobalVariable *gv =
+      ctx_->getModRefSummary().getGlobal(objectGlobals_[object]);
+    std::string name = "G:" + gv->getName().str();
+    DependenceType dt;
+    if (outputDep)
+      dt = OutputDependence;
+    else if (trueDep)
+      dt = iA < iB ? TrueDependence : AntiDependence;
+    else
+      dt = iA < iB ? AntiDependence : TrueDependence;
+    dg->addDependence(iA, iB, dt, name, name);
+    return;
+  }
+
+  // DS nodes: a write before a read wins over the other orders
+  std::string objA = getAccess(a, object).name;
+  std::string objB = getAccess(b, object).name;
+  if (trueDep) {
+    if (iA < iB)
+      dg->addDependence(iA, iB, TrueDependence, objA, objB);
+    else
+      dg->addDependence(iB, iA, AntiDependence, objB, objA);
+  } else if (antiDep) {
+    if (iA < iB)
+      dg->addDependence(iA, iB, AntiDependence, objA, objB);
+    else
+      dg->addDependence(iB, iA, TrueDependence, objB, objA);
+  } else
+    dg->addDependence(iA, iB, OutputDependence, objA, objB);
+}
@@ -22,17 +22,22 @@ void llvm::CorrelationAnalysis::analyze(Function* parent,
          "Error, instructions are no function calls!");
 
   DGNodeSet::DepGraphMapTy::iterator dgIt = ctx_->getDepGraphs()->find(parent);
-  Function *fA = ctx_->getFunctionPtr(CallSite(iA));
+  AnalysisContext::CalleeVecTy callees;
+  if (!ctx_->getCallees(CallSite(iA), callees))
+    return;
 
+  // an indirect call may be correlated through any of its targets
+  for (AnalysisContext::CalleeVecTy::iterator iCallee = callees.begin(),
+        eCallee = callees.end(); iCallee != eCallee; ++iCallee) {
+    Function *fA = iCallee->first;
 
-  if (fA) {
     // consider pointer/reference parameters
   	Function::arg_iterator it = fA->arg_begin(), e = fA->arg_end();
   	for (; it != e; ++it) {
       if (it->getType()->isPointerTy()) {
       	if (getModRefForArg(fA, &*it) & Mod) {
           Value *arg = iA->getOperand(it->getArgNo());
-          if (checkDefUse(arg, &*iB, 0, false, false)) {
+          if (checkDefUse(parent, arg, &*iB, false)) {
             dgIt->second->addDependence(iA, iB, ControlDependence,
                                       arg->getName(), "-");
           }
@@ -41,20 +46,19 @@ void llvm::CorrelationAnalysis::analyze(Function* parent,
     }
 
   	// consider modified globals
-  	checkGlobalDependencies(fA);
-    GlobAccMapTy &gMapA = (*ctx_->getGlobals())[fA];
-    for (GlobAccMapTy::iterator iGA = gMapA.begin(), eGA = gMapA.end();
-          iGA != eGA; ++iGA) {
-    	if (iGA->second == Change &&
-    			checkDefUse(iGA->first, &*iB, 0, false, false)) {
+    const ModRefSummary &summary = ctx_->getModRefSummary();
+    const BitVector &writesA = summary.getWrites(fA);
+    for (int i = writesA.find_first(); i != -1; i = writesA.find_next(i)) {
+      GlobalVariable *gv = summary.getGlobal(i);
+    	if (checkDefUse(parent, gv, &*iB, false)) {
 					dgIt->second->addDependence(iA, iB, ControlDependence,
-                                  iGA->first->getName(), "-");
+                                  gv->getName(), "-");
       }
     }
-
-		// consider instruction itself (control dependence caused by a return value)
-		if (checkDefUse(&*iA, &*iB, 0, true, false)) {
-			dgIt->second->addDependence(iA, iB, CorrelationDependece, NoObj, NoObj);
-		}
   }
+
+	// consider instruction itself (control dependence caused by a return value)
+	if (checkDefUse(parent, &*iA, &*iB, true)) {
+		dgIt->second->addDependence(iA, iB, CorrelationDependece, NoObj, NoObj);
+	}
 }
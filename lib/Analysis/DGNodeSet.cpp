@@ -11,17 +11,45 @@
 #include "Analysis/DGNodeSet.h"
 #include "Analysis/AnalysisContext.h"
 
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <cmath>
 #include <set>
 #include <numeric>
 
 using namespace llvm;
 
+static cl::opt<double>
+TimeQuantile("parpot-time-quantile",
+             cl::desc("Quantile of the execution times of a call site over "
+                      "its calling contexts, weighted by their calls, used "
+                      "for the savings (default = 0.9, 1 = maximum)"),
+             cl::init(0.9));
+
+// computeMinSaving - Returns the time saved at least by running the calls in
+// parallel.
+static double computeMinSaving(const std::vector<double> &times) {
+  return *std::min_element(times.begin(), times.end());
+}
+
+// computeMaxSaving - Returns the time saved at most by running the calls in
+// parallel.
+static double computeMaxSaving(const std::vector<double> &times) {
+  return std::accumulate(times.begin(), times.end(), 0.0) -
+         *std::max_element(times.begin(), times.end());
+}
+
 DGNodeSet::DGNodeSet(const DepGraph &graph, const DGNodeVecTy &dSet,
-	const AnalysisContext &ctx) : graph_(&graph), nodes_(dSet), trueDeps_(0),
-													antiDeps_(0), outDeps_(0), cntDeps_(0), domDeps_(0) {
-  std::vector<double> times;
+	const AnalysisContext &ctx) : graph_(&graph), nodes_(dSet), minSaving_(0.0),
+	                    maxSaving_(0.0), minSavingLo_(0.0), minSavingHi_(0.0),
+	                    maxSavingLo_(0.0), maxSavingHi_(0.0), score_(0.0),
+	                    scoreLo_(0.0), scoreHi_(0.0), trueDeps_(0),
+													antiDeps_(0), outDeps_(0), cntDeps_(0), domDeps_(0),
+													rankStable_(true) {
+  assert(graph.isFinalized() && "Dependence graph isn't finalized!");
+  std::vector<double> times, timesLo, timesHi;
 
   // compare dependencies pairwise
   for (DGNodeVecTy::const_iterator it = nodes_.begin(), e = nodes_.end();
@@ -30,16 +58,31 @@ DGNodeSet::DGNodeSet(const DepGraph &graph, const DGNodeVecTy &dSet,
         (*it)->getInstruction() != (*ti)->getInstruction(); ++ti)
       findDeps(graph, *it, *ti, true);
 
-    // collect runtimes
-    times.push_back(ctx.getDCG()->getExecutionTime((*it)->getInstruction()));
+    // collect runtimes over the calling contexts and their confidence bounds
+    double lo, hi;
+    Instruction *inst = (*it)->getInstruction();
+    times.push_back(ctx.getDCG()->getExecutionTime(inst, TimeQuantile));
+    ctx.getDCG()->getExecutionTimeBounds(inst, TimeQuantile, lo, hi);
+    timesLo.push_back(lo);
+    timesHi.push_back(hi);
   }
 
-	// calculate min/max savings
+	// calculate min/max savings; both are monotone in every time, so the
+	// bounds of the times yield the bounds of the savings
   if (times.size() > 1) {
-		minSaving_ = *std::min_element(times.begin(), times.end());
-		maxSaving_ = std::accumulate(times.begin(), times.end(), 0.0) -
-               *std::max_element(times.begin(), times.end());
+		minSaving_ = computeMinSaving(times);
+		maxSaving_ = computeMaxSaving(times);
+		minSavingLo_ = computeMinSaving(timesLo);
+		minSavingHi_ = computeMinSaving(timesHi);
+		maxSavingLo_ = computeMaxSaving(timesLo);
+		maxSavingHi_ = computeMaxSaving(timesHi);
   }
+
+  // the scores are compared often when the sets are ranked
+  double factor = getDepFactor();
+  score_ = factor * maxSaving_;
+  scoreLo_ = factor * maxSavingLo_;
+  scoreHi_ = factor * maxSavingHi_;
 }
 
 bool DGNodeSet::findDeps(const DepGraph &graph, DepGraphNode *src,
@@ -59,13 +102,13 @@ bool DGNodeSet::findDeps(const DepGraph &graph, DepGraphNode *src,
   for (DepGraphNode::const_iterator it = src->outDepBegin(),
       e = src->outDepEnd(); it != e; ++it) {
 
-  	if ((*it)->getToOrFromNode() == dst) {
-  		if ((*it)->getDepType() & TrueDependence) trueDeps_++;
-      if ((*it)->getDepType() & AntiDependence) antiDeps_++;
-      if ((*it)->getDepType() & OutputDependence) outDeps_++;
-      if ((*it)->getDepType() & ControlDependence) cntDeps_++;
-      if ((*it)->getDepType() & NoDominateDependence) domDeps_++;
-      deps_.insert(*it);
+  	if (it->getToOrFromNode() == dst) {
+  		if (it->getDepType() & TrueDependence) trueDeps_++;
+      if (it->getDepType() & AntiDependence) antiDeps_++;
+      if (it->getDepType() & OutputDependence) outDeps_++;
+      if (it->getDepType() & ControlDependence) cntDeps_++;
+      if (it->getDepType() & NoDominateDependence) domDeps_++;
+      deps_.insert(it);
       result = true;
   	}
 
@@ -83,19 +126,18 @@ bool DGNodeSet::findDeps(const DepGraph &graph, DepGraphNode *src,
   return result;
 }
 
-bool DGNodeSet::compare(const DGNodeSet *lhs, const DGNodeSet *rhs) {
+double DGNodeSet::getDepFactor() const {
 
   // compute factored dependence counts
-  double valL = TRUE_FACTOR * lhs->trueDeps_ + ANTI_FACTOR * lhs->antiDeps_
-                 + OUT_FACTOR * lhs->outDeps_ + CNT_FACTOR * lhs->cntDeps_
-                 + DOM_FACTOR * lhs->domDeps_;
-  double valR = TRUE_FACTOR * rhs->trueDeps_ + ANTI_FACTOR * rhs->antiDeps_
-                 + OUT_FACTOR * rhs->outDeps_ + CNT_FACTOR * rhs->cntDeps_
-                 + DOM_FACTOR * rhs->domDeps_;
-
-  // compute weighted savings for comparing
-  valL = exp (-(valL / 10)) * lhs->maxSaving_;
-  valR = exp (-(valR / 10)) * rhs->maxSaving_;
-
-  return (valL > valR);
+  double val = TRUE_FACTOR * trueDeps_ + ANTI_FACTOR * antiDeps_
+               + OUT_FACTOR * outDeps_ + CNT_FACTOR * cntDeps_
+               + DOM_FACTOR * domDeps_;
+
+  return exp (-(val / 10));
+}
+
+bool DGNodeSet::compare(const DGNodeSet *lhs, const DGNodeSet *rhs) {
+
+  // compare weighted savings
+  return (lhs->getScore() > rhs->getScore());
 }
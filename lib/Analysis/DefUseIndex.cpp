@@ -0,0 +1,139 @@
+//=========== DefUseIndex.cpp - Def-use reachability - Implementation ========//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the def-use reachability index of call sites.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Analysis/DefUseIndex.h"
+
+#include "llvm/IntrinsicInst.h"
+#include "llvm/Operator.h"
+#include "llvm/Support/InstIterator.h"
+
+using namespace llvm;
+
+void DefUseIndex::reset(Function *F) {
+  clear();
+  func_ = F;
+  for (inst_iterator it = inst_begin(F), e = inst_end(F); it != e; ++it)
+    if (isa<CallInst>(&*it) || isa<InvokeInst>(&*it)) {
+      unsigned idx = callSites_.size();
+      callSites_[&*it] = idx;
+    }
+}
+
+void DefUseIndex::clear(void) {
+  for (DenseMap<const Value*, ReachSets*>::iterator it = reach_.begin(),
+        e = reach_.end(); it != e; ++it)
+    delete it->second;
+  reach_.clear();
+  callSites_.clear();
+  func_ = 0;
+}
+
+bool DefUseIndex::reaches(Value *V, const Instruction *callSite,
+                          bool viaValue) {
+  DenseMap<const Instruction*, unsigned>::const_iterator idx =
+    callSites_.find(callSite);
+  if (idx == callSites_.end())
+    return false;
+
+  ReachSets *&sets = reach_[V];
+  if (!sets) {
+    sets = new ReachSets();
+    sets->viaValue.resize(callSites_.size());
+    sets->viaBranch.resize(callSites_.size());
+    compute(V, *sets);
+  }
+  return sets->viaBranch[idx->second] ||
+         (viaValue && sets->viaValue[idx->second]);
+}
+
+void DefUseIndex::mark(const Instruction *I, bool viaBranch,
+                       ReachSets &sets) const {
+  DenseMap<const Instruction*, unsigned>::const_iterator idx =
+    callSites_.find(I);
+  if (idx == callSites_.end())
+    return;
+  if (viaBranch)
+    sets.viaBranch.set(idx->second);
+  else
+    sets.viaValue.set(idx->second);
+}
+
+void DefUseIndex::compute(Value *V, ReachSets &sets) const {
+  // a value is visited at most once per kind of path
+  DenseSet<const Value*> visited[2];
+  DenseSet<const BranchInst*> branches;
+  std::vector<WorkItemTy> work;
+  work.push_back(WorkItemTy(V, false));
+
+  while (!work.empty()) {
+    Value *val = work.back().first;
+    bool viaBranch = work.back().second;
+    work.pop_back();
+    if (!visited[viaBranch].insert(val).second)
+      continue;
+
+    // check if the value is correlated with a call site
+    if (isa<CallInst>(val) || isa<InvokeInst>(val))
+      mark(cast<Instruction>(val), viaBranch, sets);
+
+    // consider store instructions
+    if (StoreInst *sInst = dyn_cast<StoreInst>(val))
+      work.push_back(WorkItemTy(sInst->getPointerOperand(), viaBranch));
+
+    // consider branch instructions
+    if (BranchInst *bInst = dyn_cast<BranchInst>(val))
+      visitBranch(bInst, sets, work, branches);
+
+    // consider llvm.memcpy instructions
+    if (MemCpyInst *mcpInst = dyn_cast<MemCpyInst>(val)) {
+      Value *v = mcpInst->getArgOperand(0);
+      work.push_back(WorkItemTy(v, viaBranch));
+      if (Operator::getOpcode(v) == Instruction::BitCast)
+        work.push_back(WorkItemTy(cast<Operator>(v)->getOperand(0),
+                                  viaBranch));
+    }
+
+    // check every use of the value
+    for (Value::use_iterator iUse = val->use_begin(), eUse = val->use_end();
+          iUse != eUse; ++iUse)
+      work.push_back(WorkItemTy(*iUse, viaBranch));
+  }
+}
+
+void DefUseIndex::visitBranch(BranchInst *B, ReachSets &sets,
+                              std::vector<WorkItemTy> &work,
+                              DenseSet<const BranchInst*> &branches) const {
+  std::vector<BranchInst*> pending(1, B);
+  while (!pending.empty()) {
+    BranchInst *bInst = pending.back();
+    pending.pop_back();
+    if (!branches.insert(bInst).second)
+      continue;
+
+    for (unsigned i = 0; i < bInst->getNumSuccessors(); ++i) {
+      BasicBlock *bb = bInst->getSuccessor(i);
+      for (BasicBlock::iterator it = bb->begin(), e = bb->end();
+            it != e; ++it) {
+
+        // stores and PHINodes within branches depend on the branch
+        if (isa<StoreInst>(&*it) || isa<PHINode>(&*it))
+          work.push_back(WorkItemTy(&*it, true));
+
+        // check if branch is correlated with a call site
+        if (isa<CallInst>(&*it) || isa<InvokeInst>(&*it))
+          mark(&*it, true, sets);
+
+        // consider new branch instructions within branches
+        if (BranchInst *nested = dyn_cast<BranchInst>(&*it))
+          pending.push_back(nested);
+      }
+    }
+  }
+}
@@ -11,34 +11,92 @@
 #include "Analysis/DepGraph.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <memory>
+
 using namespace llvm;
 
 void DepGraph::addDependence(Instruction *iA, Instruction *iB,
-      DependenceType depType, std::string ownObj, std::string fgnObj)  {
+      DependenceType depType, StringRef ownObj, StringRef fgnObj)  {
   DepGraphNode *fromNode = getNode(iA, true);
   DepGraphNode *toNode = getNode(iB, true);
 
-  fromNode->addDependency(new Dependence(toNode, depType,
-      ownObj, fgnObj, false));
-  toNode->addDependency(new Dependence(fromNode, depType,
-      fgnObj, ownObj, true));
+  pending_.push_back(PendingDep(fromNode->index_, toNode->index_, depType,
+                                intern(ownObj), intern(fgnObj)));
+}
+
+void DepGraph::finalize(void) {
+
+  // a pair analyzed again with another profile finds its old dependences too
+  std::vector<PendingDep>::iterator last = pending_.begin();
+  for (std::vector<PendingDep>::const_iterator it = pending_.begin(),
+        e = pending_.end(); it != e; ++it) {
+    const DepGraphNode *fromNode = nodes_[it->from];
+    if (std::find(fromNode->outDepBegin(), fromNode->outDepEnd(),
+                  Dependence(nodes_[it->to], it->type, it->ownObj, it->fgnObj,
+                             false)) == fromNode->outDepEnd())
+      *last++ = *it;
+  }
+  pending_.erase(last, pending_.end());
+  if (pending_.empty())
+    return;
+
+  // count the dependences of each node; existing ones are kept in front
+  std::vector<unsigned> numIn(nodes_.size(), 0), numOut(nodes_.size(), 0);
+  for (unsigned i = 0, e = nodes_.size(); i != e; ++i) {
+    numIn[i] = nodes_[i]->numIncoming_;
+    numOut[i] = nodes_[i]->numOutgoing_;
+  }
+  for (std::vector<PendingDep>::const_iterator it = pending_.begin(),
+        e = pending_.end(); it != e; ++it) {
+    ++numOut[it->from];
+    ++numIn[it->to];
+  }
+
+  // hand out slices of a single array
+  size_t total = 2 * pending_.size();
+  for (unsigned i = 0, e = nodes_.size(); i != e; ++i)
+    total += nodes_[i]->numIncoming_ + nodes_[i]->numOutgoing_;
+  Dependence *deps = allocator_.Allocate<Dependence>(total);
+  for (unsigned i = 0, e = nodes_.size(); i != e; ++i) {
+    DepGraphNode *node = nodes_[i];
+    std::uninitialized_copy(node->outDepBegin(), node->outDepEnd(), deps);
+    node->outgoing_ = deps;
+    deps += numOut[i];
+    std::uninitialized_copy(node->inDepBegin(), node->inDepEnd(), deps);
+    node->incoming_ = deps;
+    deps += numIn[i];
+  }
+
+  for (std::vector<PendingDep>::const_iterator it = pending_.begin(),
+        e = pending_.end(); it != e; ++it) {
+    DepGraphNode *fromNode = nodes_[it->from], *toNode = nodes_[it->to];
+    new (&fromNode->outgoing_[fromNode->numOutgoing_++])
+      Dependence(toNode, it->type, it->ownObj, it->fgnObj, false);
+    new (&toNode->incoming_[toNode->numIncoming_++])
+      Dependence(fromNode, it->type, it->fgnObj, it->ownObj, true);
+  }
+
+  std::vector<PendingDep>().swap(pending_);
 }
 
 const DepGraphNode* DepGraph::getNode(const Instruction *cs) const  {
-  return const_cast<DepGraph *>(this)->getNode(
-      const_cast<Instruction *>(cs));
+  DenseMap<const Instruction*, unsigned>::const_iterator it =
+    nodeIndex_.find(cs);
+  return it != nodeIndex_.end() ? nodes_[it->second] : NULL;
 }
 
 DepGraphNode* DepGraph::getNode(Instruction *cs, bool createIfMissing) {
-    iterator it = depNodeMap_.find(cs);
-    if (it == depNodeMap_.end()) {
-      if (createIfMissing) {
-        depNodeMap_[cs] =  new DepGraphNode(cs);
-        return depNodeMap_[cs];
-      }
-      else
-        return NULL;
-    }
-
-    return it->second;
-  }
+  DenseMap<const Instruction*, unsigned>::const_iterator it =
+    nodeIndex_.find(cs);
+  if (it != nodeIndex_.end())
+    return nodes_[it->second];
+  if (!createIfMissing)
+    return NULL;
+
+  DepGraphNode *node = new (allocator_.Allocate<DepGraphNode>())
+    DepGraphNode(cs, nodes_.size());
+  nodeIndex_[cs] = node->index_;
+  nodes_.push_back(node);
+  return node;
+}
@@ -1,61 +1,40 @@
-//======== GlobalsAnalysis.cpp - Globals Analysis - Implementation -========//
+//======= DominatorAnalysis.cpp - Dominator Analysis - Implementation -======//
 //
 //                 ParPot - Parallelization Potential - Measurement
 //
 //===----------------------------------------------------------------------===//
 //
-// This file defines the globals analyis.
+// This file defines the dominator analyis.
 //
 //===----------------------------------------------------------------------===//
 
 #include "Analysis/DominatorAnalysis.h"
 
 #include "llvm/Analysis/Dominators.h"
-#include "llvm/Pass.h"
-#include "llvm/PassManager.h"
+#include "llvm/Analysis/PostDominators.h"
 #include "llvm/Function.h"
 
 using namespace llvm;
 
-class LoaderInterface : public ModulePass {
-	DominatorTree *DT_;
-	Function* f_;
-public:
-	static char ID; // Class identification, replacement for typeinfo
-	explicit LoaderInterface(Function* f) : ModulePass(ID), f_(f) {}
-
-	virtual void getAnalysisUsage(AnalysisUsage &AU) const {
-		AU.setPreservesAll();
-		AU.addRequired<DominatorTree>();
-	}
-
-	DominatorTree* getDT() {
-		return DT_;
-	}
-
-	bool runOnModule(Module &M) {
-		DT_ = &getAnalysis<DominatorTree>();
-		return false;
-	}
-};
-
-char LoaderInterface::ID = 0;
+// executedTogether - Returns true if every execution of the function that
+// reaches one of the instructions reaches the other as well.
+static bool executedTogether(DominatorTree *dT, PostDominatorTree *pdT,
+                             Instruction *iA, Instruction *iB) {
+  BasicBlock *bA = iA->getParent(), *bB = iB->getParent();
+  if (bA == bB)
+    return true;
+  return (dT->dominates(bA, bB) && pdT->dominates(bB, bA)) ||
+         (dT->dominates(bB, bA) && pdT->dominates(bA, bB));
+}
 
 void DominatorAnalysis::analyze(Function *parent,
 																Instruction *iA, Instruction *iB) {
-  // get dominator tree for function
-  PassManager PassMgr = PassManager();
-  PassMgr.add(createProfileLoaderPass());
-  LoaderInterface *LI = new LoaderInterface(parent);
-  PassMgr.add(LI);
-  PassMgr.run(*ctx_->getMod());
-  DominatorTree *dT = LI->getDT();
-
-  Instruction *first, *second;
-  if (iA < iB) { first = iA; second = iB; }
-  else { first = iB; second = iA; }
+  // the trees are computed once per function by the context
+  DominatorTree *dT = ctx_->getDomTree(*parent);
+  PostDominatorTree *pdT = ctx_->getPostDomTree(*parent);
+  assert(dT && pdT && "No dominator trees found for function");
 
-  if (!dT->dominates(first, second)){
+  if (!executedTogether(dT, pdT, iA, iB)) {
 
     // get dependence graph
     DGNodeSet::DepGraphMapTy::iterator dgIt= ctx_->getDepGraphs()->find(parent);
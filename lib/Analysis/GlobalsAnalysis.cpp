@@ -17,38 +17,22 @@ void llvm::GlobalsAnalysis::analyze(Function *parent,
   assert ((isa<CallInst>(iA) || isa<InvokeInst>(iA)) && "Invalid instruction!");
   assert ((isa<CallInst>(iB) || isa<InvokeInst>(iB)) && "Invalid instruction!");
 
-  // get called functions of instruction A and B and check dependencies with
-  // global variables
-  Function *fA = ctx_->getFunctionPtr(CallSite(iA));
-  Function *fB = ctx_->getFunctionPtr(CallSite(iB));
-  checkGlobalDependencies(fA);
-  checkGlobalDependencies(fB);
-  GlobAccMapTy &gMapA = (*ctx_->getGlobals())[fA];
-  GlobAccMapTy &gMapB = (*ctx_->getGlobals())[fB];
-
   // get dependence graph
   DGNodeSet::DepGraphMapTy::iterator dgIt = ctx_->getDepGraphs()->find(parent);
   assert(dgIt != ctx_->getDepGraphs()->end()
 						&& "No dependence graph found for function");
 
-  // compare dependence sets
-  for (GlobAccMapTy::iterator iGA = gMapA.begin(), eGA = gMapA.end();
-        iGA != eGA; ++iGA) {
-    GlobAccMapTy::iterator iGB = gMapB.find(iGA->first);
-    if (iGB != gMapB.end()) {
-      DependenceType dt;
-      if (iGA->second == Change && iGB->second == Read)
-        if (iA < iB) dt = TrueDependence;
-        else dt = AntiDependence;
-      else if (iGA->second == Read && iGB->second == Change)
-        if (iA < iB) dt = AntiDependence;
-        else dt = TrueDependence;
-      else if (iGA->second == Change && iGB->second == Change)
-        dt = OutputDependence;
-      else continue;
+  ConflictMatrix matrix(ctx_);
+  matrix.clear();
+  addAccesses(matrix, matrix.addSite(iA));
+  addAccesses(matrix, matrix.addSite(iB));
+  matrix.addDependences(dgIt->second);
+}
 
-      dgIt->second->addDependence(iA, iB, dt,
-                        "G:"+iGA->first->getName().str(), "G:"+iGA->first->getName().str());
-    }
-  }
+void llvm::GlobalsAnalysis::addAccesses(ConflictMatrix &matrix,
+                                        unsigned site) {
+  // indirect calls access the globals of all their targets
+  BitVector reads, writes;
+  getGlobalsForCallSite(CallSite(matrix.getSite(site)), reads, writes);
+  matrix.addGlobals(site, reads, writes);
 }
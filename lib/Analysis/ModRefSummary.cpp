@@ -0,0 +1,261 @@
+//========= ModRefSummary.cpp - Mod/ref summaries - Implementation ===========//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the mod/ref summaries of functions.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Analysis/ModRefSummary.h"
+
+#include "llvm/Constants.h"
+#include "llvm/Instructions.h"
+#include "llvm/Operator.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Support/InstIterator.h"
+
+#include <algorithm>
+
+using namespace llvm;
+
+ModRefSummary::ModRefSummary(AnalysisContext &ctx) : ctx_(ctx) {
+  Module *M = ctx_.getMod();
+  for (Module::global_iterator G = M->global_begin(), E = M->global_end();
+       G != E; ++G)
+    globals_.push_back(&*G);
+  noGlobals_.resize(globals_.size());
+
+  // the direct accesses to globals seed the summaries
+  for (Module::iterator F = M->begin(), E = M->end(); F != E; ++F)
+    if (!F->isDeclaration()) {
+      FunctionModRef &summary = summaries_[&*F];
+      summary.reads.resize(globals_.size());
+      summary.writes.resize(globals_.size());
+    }
+  for (unsigned i = 0, e = globals_.size(); i != e; ++i)
+    indexGlobal(i, globals_[i]);
+
+  for (Module::iterator F = M->begin(), E = M->end(); F != E; ++F)
+    if (!F->isDeclaration() && !index_.count(&*F))
+      visit(&*F);
+
+  // the state of the traversal isn't needed anymore
+  index_.clear();
+  lowLink_.clear();
+  onStack_.clear();
+}
+
+void ModRefSummary::indexGlobal(unsigned num, Value *V) {
+  for (Value::use_iterator iUse = V->use_begin(), eUse = V->use_end();
+       iUse != eUse; ++iUse) {
+    User *U = *iUse;
+    if (LoadInst *load = dyn_cast<LoadInst>(U)) {
+      if (load->getPointerOperand() == V)
+        summaries_[load->getParent()->getParent()].reads.set(num);
+    } else if (StoreInst *store = dyn_cast<StoreInst>(U)) {
+      if (store->getPointerOperand() == V)
+        summaries_[store->getParent()->getParent()].writes.set(num);
+    } else if (Operator::getOpcode(U) == Instruction::GetElementPtr ||
+               Operator::getOpcode(U) == Instruction::BitCast) {
+      // addresses within the global, as GetUnderlyingObject sees them
+      indexGlobal(num, U);
+    }
+  }
+}
+
+void ModRefSummary::visit(Function *F) {
+  unsigned idx = index_.size();
+  index_[F] = idx;
+  lowLink_[F] = idx;
+  stack_.push_back(F);
+  onStack_.insert(F);
+
+  for (inst_iterator it = inst_begin(F), e = inst_end(F); it != e; ++it) {
+    if (!isa<CallInst>(&*it) && !isa<InvokeInst>(&*it))
+      continue;
+
+    AnalysisContext::CalleeVecTy callees;
+    ctx_.getCallees(CallSite(&*it), callees);
+    for (AnalysisContext::CalleeVecTy::iterator iC = callees.begin(),
+          eC = callees.end(); iC != eC; ++iC) {
+      Function *callee = iC->first;
+      if (!index_.count(callee)) {
+        visit(callee);
+        lowLink_[F] = std::min(lowLink_[F], lowLink_[callee]);
+      } else if (onStack_.count(callee))
+        lowLink_[F] = std::min(lowLink_[F], index_[callee]);
+    }
+  }
+
+  // F is the root of a component; the components it calls are complete
+  if (lowLink_[F] == index_[F]) {
+    FuncVecTy component;
+    Function *member;
+    do {
+      member = stack_.back();
+      stack_.pop_back();
+      onStack_.erase(member);
+      component.push_back(member);
+    } while (member != F);
+    computeComponent(component);
+  }
+}
+
+void ModRefSummary::computeComponent(const FuncVecTy &component) {
+  for (FuncVecTy::const_iterator it = component.begin(), e = component.end();
+       it != e; ++it)
+    summaries_[*it].args.assign((*it)->arg_size(), NoModRef);
+
+  // the summaries only grow, so the iteration terminates
+  bool changed;
+  do {
+    changed = false;
+    for (FuncVecTy::const_iterator it = component.begin(),
+          e = component.end(); it != e; ++it)
+      if (computeFunction(*it))
+        changed = true;
+  } while (changed);
+}
+
+bool ModRefSummary::computeFunction(Function *F) {
+  FunctionModRef &summary = summaries_[F];
+  bool changed = false;
+
+  // Definitions with weak linkage may be overridden at linktime with
+  // something that writes memory, so treat them like declarations.
+  if (!F->mayBeOverridden())
+    for (Function::arg_iterator A = F->arg_begin(), E = F->arg_end();
+         A != E; ++A) {
+      if (!A->getType()->isPointerTy())
+        continue;
+      std::set<const Value*> visited;
+      ArgModRefResult res = summary.args[A->getArgNo()];
+      res |= getModRefForValue(&*A, visited);
+      if (res != summary.args[A->getArgNo()]) {
+        summary.args[A->getArgNo()] = res;
+        changed = true;
+      }
+    }
+
+  // the accesses of the callees to globals
+  for (inst_iterator it = inst_begin(F), e = inst_end(F); it != e; ++it) {
+    if (!isa<CallInst>(&*it) && !isa<InvokeInst>(&*it))
+      continue;
+
+    AnalysisContext::CalleeVecTy callees;
+    ctx_.getCallees(CallSite(&*it), callees);
+    for (AnalysisContext::CalleeVecTy::iterator iC = callees.begin(),
+          eC = callees.end(); iC != eC; ++iC) {
+      SummaryMapTy::const_iterator callee = summaries_.find(iC->first);
+      if (iC->first == F || callee == summaries_.end())
+        continue;
+      unsigned reads = summary.reads.count(), writes = summary.writes.count();
+      summary.reads |= callee->second.reads;
+      summary.writes |= callee->second.writes;
+      if (summary.reads.count() != reads || summary.writes.count() != writes)
+        changed = true;
+    }
+  }
+
+  return changed;
+}
+
+ArgModRefResult
+ModRefSummary::getModRefForValue(const Value *V,
+                                 std::set<const Value*> &visited) const {
+  ArgModRefResult result = NoModRef;
+  if (!visited.insert(V).second)
+    return result;
+
+  for (Value::const_use_iterator iUse = V->use_begin(), eUse = V->use_end();
+       iUse != eUse; ++iUse) {
+    const Instruction *I = dyn_cast<Instruction>(*iUse);
+    if (!I)
+      continue;
+
+    switch (I->getOpcode()) {
+    case Instruction::Call:
+    case Instruction::Invoke: {
+      CallSite cs(const_cast<Instruction*>(I));
+      AnalysisContext::CalleeVecTy callees;
+      // Not captured if the callee is readonly, doesn't return a copy through
+      // its return value and doesn't unwind (a readonly function can leak bits
+      // by throwing an exception or not depending on the input value).
+      if (!ctx_.getCallees(cs, callees) || (cs.onlyReadsMemory()
+                                            && cs.doesNotThrow()
+                                            && I->getType()->isVoidTy()))
+        break;
+
+      // the value may be passed as several arguments to several callees
+      for (AnalysisContext::CalleeVecTy::iterator iC = callees.begin(),
+            eC = callees.end(); iC != eC; ++iC) {
+        SummaryMapTy::const_iterator callee = summaries_.find(iC->first);
+        if (callee == summaries_.end())
+          continue;
+        const std::vector<ArgModRefResult> &args = callee->second.args;
+        unsigned argNo = 0;
+        for (CallSite::arg_iterator iArg = cs.arg_begin(),
+              eArg = cs.arg_end(); iArg != eArg && argNo < args.size();
+             ++iArg, ++argNo)
+          if (iArg->get() == V)
+            result |= args[argNo];
+      }
+      break;
+    }
+    case Instruction::Load:
+      if (V == I->getOperand(0))
+        result |= Ref;
+      break;
+    case Instruction::Ret:
+      result |= Ref;
+      break;
+    case Instruction::Store:
+      if (V == I->getOperand(1))
+        result |= Mod;
+      break;
+    case Instruction::GetElementPtr:
+    case Instruction::BitCast:
+    case Instruction::PHI:
+    case Instruction::Select:
+      // The original value is not touched via this if the new value isn't.
+      result |= getModRefForValue(I, visited);
+      break;
+    case Instruction::ICmp:
+      // Comparisons of malloc results with null don't access the memory.
+      if (isNoAliasCall(V->stripPointerCasts()))
+        if (const ConstantPointerNull *CPN =
+              dyn_cast<ConstantPointerNull>(I->getOperand(1)))
+          if (CPN->getType()->getAddressSpace() == 0)
+            break;
+      // Otherwise, be conservative. There are crazy ways to capture pointers
+      // using comparisons.
+      result |= Ref;
+      break;
+    default:
+      // Something else - be speculative and say it isn't touched.
+      break;
+    }
+  }
+
+  return result;
+}
+
+ArgModRefResult ModRefSummary::getModRefForArg(const Function *F,
+                                               unsigned argNo) const {
+  SummaryMapTy::const_iterator it = summaries_.find(F);
+  if (it == summaries_.end() || argNo >= it->second.args.size())
+    return NoModRef;
+  return it->second.args[argNo];
+}
+
+const BitVector &ModRefSummary::getReads(const Function *F) const {
+  SummaryMapTy::const_iterator it = summaries_.find(F);
+  return it != summaries_.end() ? it->second.reads : noGlobals_;
+}
+
+const BitVector &ModRefSummary::getWrites(const Function *F) const {
+  SummaryMapTy::const_iterator it = summaries_.find(F);
+  return it != summaries_.end() ? it->second.writes : noGlobals_;
+}
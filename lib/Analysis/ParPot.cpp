@@ -15,6 +15,7 @@
 #include "DebugInfo/Subprogram.h"
 #include "DebugInfo/Allocation.h"
 #include "DebugInfo/GlobalVar.h"
+#include "Support/ThreadPool.h"
 
 #include "llvm/Function.h"
 #include "llvm/Support/InstIterator.h"
@@ -22,10 +23,40 @@
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Metadata.h"
 #include "llvm/LLVMContext.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+
 using namespace llvm;
 
+static cl::list<std::string>
+ProfileFiles("parpot-profile",
+             cl::CommaSeparated,
+             cl::desc("Additional dynamic call graph files that are evaluated "
+                      "with the same dependence analysis; the dependences "
+                      "found with earlier profiles are kept"),
+             cl::value_desc("filename"));
+
+static cl::opt<double>
+MinFraction("parpot-min-fraction",
+            cl::desc("Skip functions and sets whose calls take less than this "
+                     "fraction of the total time (default = 0.01, 0 = analyze "
+                     "all)"),
+            cl::init(0.01));
+
+static cl::opt<unsigned>
+MaxSets("parpot-max-sets",
+        cl::desc("Number of best sets kept per profile (default = 1000, "
+                 "0 = all)"),
+        cl::init(1000));
+
+static cl::opt<unsigned>
+AnalysisThreads("parpot-threads",
+                cl::desc("Number of threads analyzing the dependencies of "
+                         "functions (default = one per processor)"),
+                cl::init(0));
+
 const std::string ParPot::Separator =
 "  -------------------------------------------------------------------------\n";
 
@@ -43,10 +74,10 @@ bool ParPot::runOnModule(Module &M) {
 															 &getAnalysis<EquivBUDataStructures>(),
 															 &getAnalysis<BUDataStructures>());
 
-    // prepare analysis
-		pointerAnalysis = new PointerAnalysis(ctx_);
-    corrAnalysis = new CorrelationAnalysis(ctx_);
-    globalsAnalysis = new GlobalsAnalysis(ctx_);
+    // prepare analysis; every thread has its own analyses and caches
+    unsigned numThreads = ThreadPool(AnalysisThreads).getNumThreads();
+    for (unsigned i = 0; i != numThreads; ++i)
+      workers_.push_back(new AnalysisWorker(ctx_));
 
     // iterate through static callgraph and insert missing functions from
     // dynamic callgraph where applicable
@@ -55,70 +86,220 @@ bool ParPot::runOnModule(Module &M) {
     errs() << "2. Analyze dependencies\n";
     analyzeDependencies(root->getFunction());
 		errs() << "3. Collect node sets\n";
-    collectNodeSets(root->getFunction());
+    evaluateProfile(root->getFunction(), nodeSetVec_);
 
-    // sort function sets
-		std::sort(nodeSetVec_.begin(), nodeSetVec_.end(), DGNodeSet::compare);
+    if (!ProfileFiles.empty()) {
+      errs() << "4. Evaluate additional profiles\n";
+      evaluateProfiles(M, root->getFunction());
+    }
 
     return false;
 }
 
-void ParPot::analyzeDependencies(Function *parent) {
+void ParPot::evaluateProfile(Function *root, DGNodeSet::NodeSetVecTy &sets) {
+  visitedFuncs_.clear();
+  collectNodeSets(root, sets);
 
-  // check if function has already been analyzed
-  DGNodeSet::DepGraphMapTy::const_iterator gIt =
-																					ctx_->getDepGraphs()->find(parent);
-  if (gIt != ctx_->getDepGraphs()->end())
+  // sort function sets
+  std::sort(sets.begin(), sets.end(), DGNodeSet::compare);
+  markUnstableRanks(sets);
+}
+
+void ParPot::evaluateProfiles(Module &M, Function *root) {
+  DynCallGraph *primary = ctx_->getDCG();
+  CallSiteTable table(M);
+
+  // the module and its DSA results are shared; only the times differ
+  for (unsigned i = 0, e = ProfileFiles.size(); i != e; ++i) {
+    DynCallGraph *dcg = new DynCallGraph();
+    if (!readDynCallGraph(ProfileFiles[i], *dcg)) {
+      delete dcg;
+      continue;
+    }
+    dcg->linkInstructions(table);
+
+    ctx_->setDCG(dcg);
+    analyzeDependencies(root); // functions called indirectly in this run only
+    profiles_.push_back(ProfileResult(ProfileFiles[i], dcg));
+    evaluateProfile(root, profiles_.back().nodeSets);
+  }
+  ctx_->setDCG(primary);
+}
+
+/// The AnalyzeTask class analyzes the call-site pairs of one function per
+/// work item. Each function has its own dependence graph, so only the caches
+/// of the analyses are bound to the worker.
+class ParPot::AnalyzeTask : public ParallelTask {
+  const std::vector<FunctionWork> &work_;
+  std::vector<AnalysisWorker*> &workers_;
+
+public:
+  AnalyzeTask(const std::vector<FunctionWork> &work,
+              std::vector<AnalysisWorker*> &workers)
+    : work_(work), workers_(workers) { }
+
+  virtual void run(unsigned item, unsigned worker) {
+    analyzeFunction(work_[item], *workers_[worker]);
+  }
+};
+
+void ParPot::analyzeDependencies(Function *root) {
+
+  // the dependence graphs are created before the analyses start, so the
+  // analyses only read the map of graphs
+  std::vector<FunctionWork> work;
+  visitedFuncs_.clear();
+  collectFunctions(root, work);
+
+  // the summaries are read by all workers
+  ctx_->computeModRefSummary();
+
+  AnalyzeTask task(work, workers_);
+  ThreadPool pool(workers_.size());
+  pool.run(task, work.size());
+}
+
+void ParPot::collectFunctions(Function *parent,
+                              std::vector<FunctionWork> &work) {
+
+  // visit each function only once
+  if (!visitedFuncs_.insert(parent).second)
     return;
 
-  // create dependency graph for this node
-  DepGraph *graph = new DepGraph(parent);
-  (*ctx_->getDepGraphs())[parent] = graph;
+  CallSiteVecTy sites;
+  if (!collectCallSites(parent, sites))
+    return;
 
-  typedef std::pair<DepGraphNode*, Function*> NodeTy;
-  typedef std::vector<NodeTy> DGVectTy;
-  DGVectTy nodes;
+  // create dependency graph for this node unless it has been analyzed with
+  // an earlier profile
+  DepGraph *&graph = (*ctx_->getDepGraphs())[parent];
+  if (!graph) {
+    graph = new DepGraph(parent);
+    ctx_->computeDominators(*parent);
+  }
 
   // consider every pair of a callsite for function A and a callsite
-  // for function B to check dependencies
+  // for function B to check dependencies; the callsites analyzed before
+  // come first. An indirect callsite that calls further functions with this
+  // profile is analyzed again with all others.
+  FunctionWork fw(parent, graph);
+  std::vector<DepGraphNode*> newNodes;
+  for (CallSiteVecTy::iterator it = sites.begin(), e = sites.end();
+       it != e; ++it) {
+    bool changed = addAnalyzedCallees(*it);
+    DepGraphNode *node = graph->getNode(it->first);
+    if (node && !changed)
+      fw.nodes.push_back(node);
+    else
+      newNodes.push_back(graph->getNode(it->first, /*create if missing*/ true));
+  }
+  if (!newNodes.empty()) {
+    fw.firstNew = fw.nodes.size();
+    fw.nodes.insert(fw.nodes.end(), newNodes.begin(), newNodes.end());
+    work.push_back(fw);
+  }
+
+  // collect child nodes, i.e. every target of an indirect call
+  for (CallSiteVecTy::iterator iF = sites.begin(), eF = sites.end();
+       iF != eF; ++iF)
+    for (AnalysisContext::CalleeVecTy::iterator iC = iF->second.begin(),
+          eC = iF->second.end(); iC != eC; ++iC)
+      collectFunctions(iC->first, work);
+}
+
+bool ParPot::addAnalyzedCallees(const CallSiteTy &site) {
+  std::vector<Function*> &analyzed = analyzedCallees_[site.first];
+  bool changed = false;
+  for (AnalysisContext::CalleeVecTy::const_iterator it = site.second.begin(),
+        e = site.second.end(); it != e; ++it) {
+    std::vector<Function*>::iterator pos =
+      std::lower_bound(analyzed.begin(), analyzed.end(), it->first);
+    if (pos == analyzed.end() || *pos != it->first) {
+      analyzed.insert(pos, it->first);
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+bool ParPot::collectCallSites(Function *parent, CallSiteVecTy &sites) const {
+  DynCallGraph *dcg = ctx_->getDCG();
+  double time = 0.0;
+
   for (inst_iterator it = inst_begin(parent), e = inst_end(parent);
       it != e; ++it) {
     if (isa<CallInst>(&*it) || isa<InvokeInst>(&*it)) {
       CallSite cs(&*it);
-      Function *tmp = ctx_->getFunctionPtr(cs);
-      if (!tmp) continue;
-      DepGraphNode *node = graph->getNode(&*it, /*create if missing*/ true);
-       nodes.push_back(std::make_pair(node, tmp));
+      AnalysisContext::CalleeVecTy callees;
+      if (!ctx_->getCallees(cs, callees)) continue;
+
+      // callsites that were never executed save nothing
+      if (MinFraction > 0 && !dcg->getCallSiteTimes(&*it)) continue;
+      time += dcg->getMaxContextTime(&*it);
+      sites.push_back(std::make_pair(&*it, callees));
     }
   }
 
-  for (DGVectTy::iterator iF = nodes.begin(), eF = nodes.end(); iF!=eF; iF++) {
-    for (DGVectTy::reverse_iterator iR = nodes.rbegin();
-          iF->first != iR->first; ++iR) {
+  // the saving of a set is at most the time of its calls; the calls of the
+  // children take less time than their callsites, so they are skipped too
+  return time >= MinFraction * dcg->getTotExecutionTime();
+}
 
-      /*
-       * analyze def-use correlations
-       */
-      corrAnalysis->analyze(parent, iF->first->getInstruction(),
-																		iR->first->getInstruction());
+void ParPot::analyzeFunction(const FunctionWork &work,
+                             AnalysisWorker &worker) {
+  Function *parent = work.function;
+  typedef std::vector<DepGraphNode*> DGVectTy;
+  const DGVectTy &nodes = work.nodes;
+
+  /*
+   * use alias analysis information and the use of global variables to
+   * insert possible dependencies
+   */
+  ConflictMatrix &conflicts = worker.conflicts;
+  conflicts.clear();
+  for (DGVectTy::const_iterator iF = nodes.begin(), eF = nodes.end();
+       iF != eF; ++iF) {
+    unsigned site = conflicts.addSite((*iF)->getInstruction());
+    worker.globalsAnalysis.addAccesses(conflicts, site);
+  }
+  worker.pointerAnalysis.addAccesses(parent, conflicts);
+  conflicts.addDependences(work.graph, work.firstNew);
+
+  for (unsigned i = 0, e = nodes.size(); i != e; ++i) {
+    Instruction *iA = nodes[i]->getInstruction();
+    for (unsigned j = std::max(i + 1, work.firstNew); j < e; ++j) {
+      Instruction *iB = nodes[j]->getInstruction();
 
       /*
-       * use alias analysis information to insert possible dependencies
+       * analyze def-use correlations
        */
-      pointerAnalysis->analyze(parent, iF->first->getInstruction(),
-																			 iR->first->getInstruction());
+      worker.corrAnalysis.analyze(parent, iA, iB);
 
       /*
-       * analyze use of global variables
+       * calls that aren't always executed together depend on the control flow
        */
-      globalsAnalysis->analyze(parent, iF->first->getInstruction(),
-																			 iR->first->getInstruction());
+      worker.domAnalysis.analyze(parent, iA, iB);
     }
+  }
+
+  // pack the dependences before the node sets scan them
+  work.graph->finalize();
+}
 
-    // analyze child node
-    analyzeDependencies(iF->second);
+void ParPot::markUnstableRanks(DGNodeSet::NodeSetVecTy &sets) {
+
+  // the sets are sorted by score; a rank isn't stable, if the score interval
+  // overlaps with the interval of a neighbour
+  for (unsigned i = 1; i < sets.size(); ++i) {
+    DGNodeSet *prev = sets[i - 1], *cur = sets[i];
+    if (cur->getScoreHi() > prev->getScoreLo() &&
+        prev->getScoreHi() > cur->getScoreLo()) {
+      prev->setRankStable(false);
+      cur->setRankStable(false);
+    }
   }
 }
+
 void ParPot::printDepType(raw_ostream &out, unsigned char type) const {
 
   if (type & TrueDependence)
@@ -139,29 +320,42 @@ void ParPot::print(raw_ostream &out, const Module *M) const {
 
   DebugInfoReader reader(DebugInfo::getFileName(), *const_cast<Module*>(M));
 
+  printNodeSets(out, reader, nodeSetVec_, *ctx_->getDCG());
+
+  // the results of further profiles refer to their own call graphs
+  for (std::vector<ProfileResult>::const_iterator it = profiles_.begin(),
+        e = profiles_.end(); it != e; ++it) {
+    out << "\nProfile " << it->name << ":\n";
+    printNodeSets(out, reader, it->nodeSets, *it->dcg);
+  }
+}
 
-  out << " maintime: " << ctx_->getDCG()->getTotExecutionTime() << '\n';
+void ParPot::printNodeSets(raw_ostream &out, DebugInfoReader &reader,
+                           const DGNodeSet::NodeSetVecTy &sets,
+                           const DynCallGraph &dcg) const {
+
+  out << " maintime: " << dcg.getTotExecutionTime() << '\n';
 
 
   out << "Dependence Analysis Result: \n";
 
 
   // consider all function sets
-  for (DGNodeSet::NodeSetVecTy::const_iterator iSet = nodeSetVec_.begin(),
-      e1 = nodeSetVec_.end(); iSet != e1; ++iSet) {
+  for (DGNodeSet::NodeSetVecTy::const_iterator iSet = sets.begin(),
+      e1 = sets.end(); iSet != e1; ++iSet) {
 
     // check timing
     double minPerc=((*iSet)->getMinSaving() /
-												ctx_->getDCG()->getTotExecutionTime())*100;
+												dcg.getTotExecutionTime())*100;
     double maxPerc=((*iSet)->getMaxSaving() /
-												ctx_->getDCG()->getTotExecutionTime())*100;
+												dcg.getTotExecutionTime())*100;
 
-    std::stringstream ss;
+    std::stringstream ssMin, ssMax;
     std::string sMinPerc, sMaxPerc;
-    ss << minPerc;
-    sMinPerc = ss.str();
-    ss << maxPerc;
-    sMaxPerc = ss.str();
+    ssMin << minPerc;
+    sMinPerc = ssMin.str();
+    ssMax << maxPerc;
+    sMaxPerc = ssMax.str();
 
     if (maxPerc < 1)
       continue;
@@ -184,12 +378,24 @@ void ParPot::print(raw_ostream &out, const Module *M) const {
     for (DGNodeSet::DGNodeVecTy::const_iterator iNode = (*iSet)->begin(),
 							eNode = (*iSet)->end(); iNode != eNode; iNode++) {
       CallSite cs((*iNode)->getInstruction());
-      Function *tmp = ctx_->getFunctionPtr(cs);
-      assert(tmp && "Function wasn't found in dependence graph!\n");
-      if (reader.getSubprogram(tmp->getName(), iS))
-        out << (*iS)->getDisplayName();
-      else
-        out << "IR<" << tmp->getName();
+      AnalysisContext::CalleeVecTy callees;
+      ctx_->getCallees(cs, callees, dcg);
+      assert(!callees.empty() &&
+             "Function wasn't found in dependence graph!\n");
+
+      // the targets of an indirect call are listed with their share of calls
+      for (AnalysisContext::CalleeVecTy::iterator iC = callees.begin(),
+            eC = callees.end(); iC != eC; ++iC) {
+        Function *tmp = iC->first;
+        if (iC != callees.begin())
+          out << " | ";
+        if (reader.getSubprogram(tmp->getName(), iS))
+          out << (*iS)->getDisplayName();
+        else
+          out << "IR<" << tmp->getName();
+        if (callees.size() > 1)
+          out << " [" << iC->second * 100 << " %]";
+      }
 
       // dump line number of instruction
       if (reader.getCallInstruction((*iNode)->getInstruction(), iC))
@@ -198,9 +404,19 @@ void ParPot::print(raw_ostream &out, const Module *M) const {
 
     // dump savings
     if (minPerc == maxPerc)
-      out << " )     saving: [ " << sMinPerc << " % ]\n";
+      out << " )     saving: [ " << sMinPerc << " % ]";
     else
-      out << " )     saving: [" << sMinPerc << " % - " << sMaxPerc << " % ]\n";
+      out << " )     saving: [" << sMinPerc << " % - " << sMaxPerc << " % ]";
+
+    // dump confidence interval of the savings over several runs
+    double totTime = dcg.getTotExecutionTime();
+    if ((*iSet)->getMinSavingLo() != (*iSet)->getMinSavingHi() ||
+        (*iSet)->getMaxSavingLo() != (*iSet)->getMaxSavingHi())
+      out << "  95% CI: [" << (*iSet)->getMinSavingLo() / totTime * 100
+          << " % - " << (*iSet)->getMaxSavingHi() / totTime * 100 << " % ]";
+    if (!(*iSet)->isRankStable())
+      out << "  (rank not stable)";
+    out << '\n';
 
     // consider every instruction that has dependencies
     for (DGNodeSet::DepSetTy::iterator iDep = (*iSet)->dep_begin(),
@@ -214,42 +430,72 @@ void ParPot::print(raw_ostream &out, const Module *M) const {
   }
 }
 
-void ParPot::collectNodeSets(Function *parent) {
+void ParPot::collectNodeSets(Function *parent, DGNodeSet::NodeSetVecTy &sets) {
 
   // visit each function only once
-  static std::set<Function *> visitedFuncs;
-  if (visitedFuncs.find(parent) != visitedFuncs.end())
+  if (!visitedFuncs_.insert(parent).second)
+    return;
+
+  // the same callsites as for the analysis are considered
+  CallSiteVecTy sites;
+  if (!collectCallSites(parent, sites))
     return;
-  visitedFuncs.insert(parent);
 
-  typedef std::pair<DepGraphNode*, Function*> NodeTy;
+  typedef std::pair<DepGraphNode*, AnalysisContext::CalleeVecTy> NodeTy;
   typedef std::vector<NodeTy> DGVectTy;
   DGVectTy nodes;
-  DepGraph *graph = (*ctx_->getDepGraphs())[parent];
-
-  // consider every pair of a callsite for function A and a callsite
-  // for function B to check dependencies
-  for (inst_iterator it = inst_begin(parent), e = inst_end(parent);
-      it != e; ++it) {
-    if (isa<CallInst>(&*it) || isa<InvokeInst>(&*it)) {
-      CallSite cs(&*it);
-      Function *tmp = ctx_->getFunctionPtr(cs);
-      if (!tmp) continue;
+  std::vector<double> times; // bound the savings of the sets
+  DGNodeSet::DepGraphMapTy::const_iterator gIt =
+                                          ctx_->getDepGraphs()->find(parent);
+  assert(gIt != ctx_->getDepGraphs()->end() && "Function wasn't analyzed!");
+  DepGraph *graph = gIt->second;
+
+  for (CallSiteVecTy::iterator it = sites.begin(), e = sites.end();
+       it != e; ++it) {
+    DepGraphNode *node = graph->getNode(it->first);
+    assert(node && "Callsite wasn't analyzed!");
+    nodes.push_back(std::make_pair(node, it->second));
+    times.push_back(ctx_->getDCG()->getMaxContextTime(it->first));
+  }
 
-      DepGraphNode *node = graph->getNode(&*it, /*create if missing*/ true);
-      nodes.push_back(std::make_pair(node, tmp));
-    }
+  // create node-sets; the saving of a pair is at most the shorter time
+  for (unsigned i = 0, e = nodes.size(); i != e; ++i) {
+    for (unsigned j = e - 1; j > i; --j)
+      addNodeSet(graph, nodes[i].first, nodes[j].first,
+                 std::min(times[i], times[j]), sets);
+    for (AnalysisContext::CalleeVecTy::iterator iC = nodes[i].second.begin(),
+          eC = nodes[i].second.end(); iC != eC; ++iC)
+      collectNodeSets(iC->first, sets);
   }
+}
+
+void ParPot::addNodeSet(DepGraph *graph, DepGraphNode *nodeA,
+                        DepGraphNode *nodeB, double bound,
+                        DGNodeSet::NodeSetVecTy &sets) {
+
+  // the score never exceeds the saving, so the dependences of hopeless sets
+  // aren't collected
+  if (bound < MinFraction * ctx_->getDCG()->getTotExecutionTime())
+    return;
+  bool full = MaxSets && sets.size() >= MaxSets;
+  if (full && bound <= sets.front()->getScore())
+    return;
+
+  DGNodeSet::DGNodeVecTy tmp;
+  tmp.push_back(nodeA);
+  tmp.push_back(nodeB);
+  DGNodeSet *set = new DGNodeSet(*graph, tmp, *ctx_);
 
-  // create node-sets
-  for (DGVectTy::iterator iF = nodes.begin(), eF = nodes.end(); iF!=eF; ++iF) {
-    for (DGVectTy::reverse_iterator iR = nodes.rbegin();
-          *iF->first != *iR->first; ++iR) {
-      DGNodeSet::DGNodeVecTy tmp;
-      tmp.push_back(iF->first);
-      tmp.push_back(iR->first);
-      nodeSetVec_.push_back(new DGNodeSet(*graph, tmp, *ctx_));
+  // replace the worst set if the new one is better
+  if (full) {
+    if (set->getScore() <= sets.front()->getScore()) {
+      delete set;
+      return;
     }
-    collectNodeSets(iF->second);
+    std::pop_heap(sets.begin(), sets.end(), DGNodeSet::compare);
+    delete sets.back();
+    sets.pop_back();
   }
+  sets.push_back(set);
+  std::push_heap(sets.begin(), sets.end(), DGNodeSet::compare);
 }
@@ -39,9 +39,11 @@ static double AddTimes(double A, double B) {
   return A + B;
 }
 
-static void ReadProfilingBlock(const char *ToolName, FILE *F,
-                               bool ShouldByteSwap,
-                               std::vector<double> &Data) {
+// ReadTimingBlock - Reads the raw timings of a data packet.
+//
+static void ReadTimingBlock(const char *ToolName, FILE *F,
+                            bool ShouldByteSwap,
+                            std::vector<double> &TempSpace) {
 	  // Read the number of entries...
 	  unsigned NumEntries;
 	  if (fread(&NumEntries, sizeof(unsigned), 1, F) != 1) {
@@ -51,27 +53,57 @@ static void ReadProfilingBlock(const char *ToolName, FILE *F,
 	  }
 	  NumEntries = ByteSwap(NumEntries, ShouldByteSwap);
 
-	  // Read the timings...
-	  std::vector<double> TempSpace(NumEntries);
-
 	  // Read in the block of data...
-	  if (fread(&TempSpace[0], sizeof(double)*NumEntries, 1, F) != 1) {
+	  TempSpace.resize(NumEntries);
+	  if (NumEntries &&
+	      fread(&TempSpace[0], sizeof(double)*NumEntries, 1, F) != 1) {
 	    errs() << ToolName << ": data packet truncated!\n";
 	    perror(0);
 	    exit(1);
 	  }
+}
+
+static void ReadProfilingBlock(const char *ToolName, FILE *F,
+                               bool ShouldByteSwap, double Weight,
+                               std::vector<double> &Data,
+                               std::vector<RunningStat> &Stats) {
+	  // Read the timings...
+	  std::vector<double> TempSpace;
+	  ReadTimingBlock(ToolName, F, ShouldByteSwap, TempSpace);
+	  unsigned NumEntries = TempSpace.size();
 
 	  // Make sure we have enough space... The space is initialised to -1 to
 	  // facitiltate the loading of missing values for OptimalEdgeProfiling.
 	  if (Data.size() < NumEntries)
 	    Data.resize(NumEntries, TimeProfileInfoLoader::Uncounted);
+	  if (Stats.size() < NumEntries)
+	    Stats.resize(NumEntries);
 
-	  // Accumulate the data we just read into the data.
+	  // Accumulate the weighted data we just read into the data. Every packet
+	  // is the result of one run and therefore one sample of the statistics.
       for (unsigned i = 0; i != NumEntries; ++i) {
+	     if (TempSpace[i] != TimeProfileInfoLoader::Uncounted) {
+	       Stats[i].add(TempSpace[i], Weight);
+	       TempSpace[i] *= Weight;
+	     }
 	     Data[i] = AddTimes(TempSpace[i], Data[i]);
 	  }
 }
 
+static void ReadLoopBlock(const char *ToolName, FILE *F, bool ShouldByteSwap,
+                          double Weight, std::vector<LoopTimeRecord> &Loops) {
+	  // Read the records...
+	  std::vector<double> TempSpace;
+	  ReadTimingBlock(ToolName, F, ShouldByteSwap, TempSpace);
+	  unsigned NumLoops = TempSpace.size() / LoopRecordSize;
+
+	  // Merge the records of this run into the loop records.
+	  if (Loops.size() < NumLoops)
+	    Loops.resize(NumLoops);
+	  for (unsigned i = 0; i != NumLoops; ++i)
+	    Loops[i].add(&TempSpace[i * LoopRecordSize], Weight);
+}
+
 const unsigned TimeProfileInfoLoader::Uncounted = ~0U;
 
 // ProfileInfoLoader ctor - Read the specified profiling data file, exiting the
@@ -89,8 +121,10 @@ TimeProfileInfoLoader::TimeProfileInfoLoader(const char *ToolName,
     exit(1);
   }
 
-  // Keep reading packets until we run out of them.
+  // Keep reading packets until we run out of them. Timings are weighted by
+  // the last RunWeightInfo packet (merged profiles of several runs).
   unsigned PacketType;
+  double Weight = 1.0;
   while (fread(&PacketType, sizeof(unsigned), 1, F) == 1) {
     // If the low eight bits of the packet are zero, we must be dealing with an
     // endianness mismatch.  Byteswap all words read from the profiling
@@ -122,9 +156,22 @@ TimeProfileInfoLoader::TimeProfileInfoLoader(const char *ToolName,
     }
 
     case FunctionTInfo:
-    	ReadProfilingBlock(ToolName, F, ShouldByteSwap, FunctionTimes);
+    	ReadProfilingBlock(ToolName, F, ShouldByteSwap, Weight, FunctionTimes,
+    	                   FunctionTimeStats);
     	break;
 
+    case LoopTInfo:
+      ReadLoopBlock(ToolName, F, ShouldByteSwap, Weight, LoopTimes);
+      break;
+
+    case RunWeightInfo:
+      if (fread(&Weight, sizeof(double), 1, F) != 1) {
+        errs() << ToolName << ": weight packet truncated!\n";
+        perror(0);
+        exit(1);
+      }
+      break;
+
     default:
       errs() << ToolName << ": Unknown packet type #" << PacketType << "!\n";
       exit(1);
@@ -17,6 +17,7 @@
 #include "llvm/Module.h"
 #include "llvm/Pass.h"
 #include "llvm/Analysis/Passes.h"
+#include "llvm/Analysis/LoopInfo.h"
 #include "Analysis/TimeProfileInfo.h"
 #include "Analysis/TimeProfileInfoLoader.h"
 #include "llvm/Support/CommandLine.h"
@@ -26,9 +27,28 @@
 #include "llvm/Support/Format.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/SmallSet.h"
+#include <algorithm>
+#include <cmath>
 #include <set>
 using namespace llvm;
 
+static cl::opt<unsigned>
+LoopThreads("loop-threads",
+            cl::desc("Number of threads assumed for DOALL loop candidates"),
+            cl::init(4));
+
+// LoopCandidateComp - Orders loop candidates by their estimated saving.
+namespace {
+  class LoopCandidateComp {
+  public:
+    bool operator()(const TimeProfileInfo::LoopCandidate &p,
+                    const TimeProfileInfo::LoopCandidate &q) const {
+      return q.Record.getDoallSaving(LoopThreads) <
+             p.Record.getDoallSaving(LoopThreads);
+    }
+  };
+}
+
 char TimeLoaderPass::ID = 0;
 static RegisterPass<TimeLoaderPass>
 X("parpot-timeprofile-loader", "Load profile information from timellvmprof.out",
@@ -42,7 +62,9 @@ bool TimeLoaderPass::runOnModule(Module &M) {
   // assign execution time information from file (average execution times are
   // calculated by using the execution count)
   FunctionTimeInformation.clear();
+  FunctionTimeStats.clear();
   std::vector<double> FuncTimes = PIL.getRawFunctionTimes();
+  const std::vector<RunningStat> &FuncStats = PIL.getFunctionTimeStats();
   if (FuncTimes.size() > 0) {
     ReadCount = 0;
     for (Module::iterator it = M.begin(), e = M.end(); it != e; ++it) {
@@ -50,6 +72,9 @@ bool TimeLoaderPass::runOnModule(Module &M) {
       if (ReadCount < FuncTimes.size()) {
         int eC = pi->getExecutionCount(it);
         if (eC == ProfileInfo::MissingValue) eC = 1;
+        RunningStat stat = FuncStats[ReadCount];
+        stat.scale(1.0 / eC);
+        setExecutionTimeStat(it, stat);
         setExecutionTime(it, FuncTimes[ReadCount++] / eC);
       }
     }
@@ -59,6 +84,33 @@ bool TimeLoaderPass::runOnModule(Module &M) {
     }
   }
 
+  // assign loop records; loops are numbered like the instrumentation does
+  LoopCandidates.clear();
+  const std::vector<LoopTimeRecord> &LoopTimes = PIL.getLoopTimes();
+  if (LoopTimes.size() > 0) {
+    ReadCount = 0;
+    for (Module::iterator it = M.begin(), e = M.end(); it != e; ++it) {
+      if (it->isDeclaration()) continue;
+      std::vector<Loop*> loops;
+      getProfiledLoops(getAnalysis<LoopInfo>(*it), loops);
+      for (std::vector<Loop*>::iterator L = loops.begin(), LE = loops.end();
+            L != LE && ReadCount < LoopTimes.size(); ++L) {
+        LoopCandidate candidate;
+        candidate.F = it;
+        candidate.Header = (*L)->getHeader();
+        candidate.Depth = (*L)->getLoopDepth();
+        candidate.Record = LoopTimes[ReadCount++];
+        LoopCandidates.push_back(candidate);
+      }
+    }
+    if (ReadCount != LoopTimes.size()) {
+      errs() << "WARNING: loop profile information is inconsistent with "
+               << "the current program!\n";
+    }
+    std::stable_sort(LoopCandidates.begin(), LoopCandidates.end(),
+                     LoopCandidateComp());
+  }
+
 
   return false;
 }
@@ -71,9 +123,33 @@ void TimeLoaderPass::print(raw_ostream &O, const Module *M) const {
         it = FunctionTimeInformation.begin(),
         e = FunctionTimeInformation.end(); it != e; ++it) {
     O << "  Function: " << it->first->getName()
-      << " Time: " << it->second
-      << '\n';
+      << " Time: " << it->second;
+
+    // print the 95% confidence interval of the mean if several runs exist
+    const RunningStat *stat = getExecutionTimeStat(it->first);
+    if (stat && stat->getWeight() > 1.0)
+      O << " (mean " << stat->getMean() << " +/- " << stat->getHalfWidth()
+        << ", " << stat->getWeight() << " runs)";
+    O << '\n';
   }
 
+  if (LoopCandidates.empty())
+    return;
+
+  O << "Loop candidates (DOALL on " << LoopThreads << " threads): \n";
+  for (LoopCandidateList::const_iterator it = LoopCandidates.begin(),
+        e = LoopCandidates.end(); it != e; ++it) {
+    const LoopTimeRecord &rec = it->Record;
+    O << "  Loop: " << it->F->getName() << '/' << it->Header->getName()
+      << " depth " << it->Depth
+      << " Time: " << rec.getTotalTime()
+      << " Trips/invocation: " << format("%.1f", rec.getTripsPerInvocation())
+      << " Iteration: " << rec.getIterStat().getMean()
+      << " [" << rec.getIterMin() << ", " << rec.getIterMax() << "]"
+      << " sd " << sqrt(rec.getIterStat().getVariance())
+      << " Imbalance: "
+      << format("%.1f", rec.getDoallImbalance(LoopThreads) * 100) << " %"
+      << " Saving: " << rec.getDoallSaving(LoopThreads) << '\n';
+  }
 }
 
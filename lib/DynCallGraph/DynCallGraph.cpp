@@ -10,58 +10,167 @@
 #include "DynCallGraph/DynCallGraph.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <memory>
+
 using namespace llvm;
 
-DynCallGraphNode* DynCallGraph::addNode(unsigned nodeID, std::string node,
-    unsigned num, double exTime) {
+/// Node IDs up to twice the number of nodes plus this slack are indexed by a
+/// vector; IDs beyond it go to a map, so that a bogus ID can't blow up the
+/// vector.
+static const unsigned DenseIDSlack = 1024;
+
+DynCallGraphNode* DynCallGraph::addNode(unsigned nodeID, StringRef node,
+    uint64_t num, double exTime, const RunningStat &stat) {
 
-  // check if node is main function
-  if (node == "main")
-    totExTime = exTime;
+  // without statistics the time is the only sample
+  RunningStat nodeStat = stat.empty() ? RunningStat(1.0, exTime, 0.0) : stat;
 
   // if a node with given id exist take it, otherwise create a new one
-  DynCallGraphNode *pNode = idMap_[nodeID];
-  DynCallGraphNode *pNodeNum = numMap_[num];
+  DynCallGraphNode *pNode = lookupID(nodeID);
   if (!pNode) {
-    pNode = new DynCallGraphNode(nodeID, node, num, exTime);
-    idMap_[nodeID] = pNode;
-    if (!pNodeNum)
-      numMap_[num] = pNode;
-    else if (pNodeNum->getExTime() < exTime)
-      pNodeNum->setExTime(exTime);
+    StringRef name = names_.GetOrCreateValue(node).getKey();
+    pNode = new (allocator_.Allocate<DynCallGraphNode>())
+      DynCallGraphNode(nodeID, name, num, exTime, nodeStat);
+    nodes_.push_back(pNode);
+    if (nodeID < idIndex_.size())
+      idIndex_[nodeID] = pNode;
+    else if (nodeID <= 2 * nodes_.size() + DenseIDSlack) {
+      idIndex_.resize(std::max<size_t>(nodeID + 1, 2 * idIndex_.size()), 0);
+      idIndex_[nodeID] = pNode;
+
+      // the runtime numbers the nodes in the order of their creation, not in
+      // the order of the file, so the vector may now cover sparse ids
+      for (DenseMap<uint64_t, DynCallGraphNode*>::iterator
+            it = sparseIndex_.begin(), e = sparseIndex_.end(); it != e; ) {
+        if (it->first < idIndex_.size()) {
+          idIndex_[it->first] = it->second;
+          sparseIndex_.erase(it++);
+        } else
+          ++it;
+      }
+    } else
+      sparseIndex_[nodeID] = pNode;
+
+    // the context with the maximum time represents the call site; its times
+    // per context are collected by finalize()
+    std::pair<DynNumMapTy::iterator, bool> numEntry =
+      numMap_.insert(std::make_pair(num, (unsigned)callSites_.size()));
+    if (numEntry.second)
+      callSites_.push_back(CallSiteTimes(pNode));
+    CallSiteTimes &site = callSites_[numEntry.first->second];
+    if (site.node->getExTime() < exTime)
+      site.node = pNode;
   }
 
-  // set root node if it's the main function
-  if (node == "main")
+  // the first main function is the root; its time is the total time
+  if (!pRoot_ && node == "main") {
     pRoot_ = pNode;
+    totExTime_ = pNode->getExTime();
+    callSites_[numMap_.find(num)->second].times.add(exTime);
+  }
 
   return pNode;
 }
 
 bool DynCallGraph::addEdge(unsigned parentID, unsigned nodeID, unsigned count) {
   // check if both nodes exist
-  DynCallGraphNode *pNode = idMap_[nodeID], *pParent = idMap_[parentID];
-  if (!(pNode && pParent))
+  if (!(lookupID(nodeID) && lookupID(parentID)))
     return false;
 
-  // add called function to parent node
-  pParent->addCalledFunction(pNode, count);
+  // the edge is added to the call list of the parent by finalize()
+  edges_.push_back(PendingEdge(parentID, nodeID, count));
 
   // increment number of total calls by count
   incTotNoCalls(count);
   return true;
 }
 
-bool DynCallGraph::linkInstruction(unsigned num, Instruction* inst) {
-  DynCallGraph::iterator node = numMap_.find(num);
-  if (node == numMap_.end())
+void DynCallGraph::finalize() {
+  if (edges_.empty())
+    return;
+
+  // count the calls of each node; existing call lists are kept in front
+  DenseMap<const DynCallGraphNode*, unsigned> numCalls;
+  size_t total = 0;
+  for (DynNodeVecTy::const_iterator it = nodes_.begin(), e = nodes_.end();
+       it != e; ++it) {
+    numCalls[*it] = (*it)->numCalledFunctions_;
+    total += (*it)->numCalledFunctions_;
+  }
+  for (std::vector<PendingEdge>::const_iterator it = edges_.begin(),
+        e = edges_.end(); it != e; ++it)
+    ++numCalls[lookupID(it->parent)];
+  total += edges_.size();
+
+  // hand out slices of a single array, keeping the order of the edges
+  DynCallGraphNode::calledFunctionTy *calls =
+    allocator_.Allocate<DynCallGraphNode::calledFunctionTy>(total);
+  for (DynNodeVecTy::const_iterator it = nodes_.begin(), e = nodes_.end();
+       it != e; ++it) {
+    DynCallGraphNode *node = *it;
+    std::uninitialized_copy(node->begin(), node->end(), calls);
+    node->calledFunctions_ = calls;
+    calls += numCalls[node];
+  }
+
+  // the targets of a call site within one context are summed up; the time of
+  // a context is weighted by its calls, so the quantiles are over invocations
+  typedef std::map<std::pair<unsigned, unsigned>, std::pair<double, uint64_t> >
+    ContextTimesTy;
+  ContextTimesTy contextTimes;
+  for (std::vector<PendingEdge>::const_iterator it = edges_.begin(),
+        e = edges_.end(); it != e; ++it) {
+    DynCallGraphNode *parent = lookupID(it->parent);
+    DynCallGraphNode *child = lookupID(it->child);
+    new (&parent->calledFunctions_[parent->numCalledFunctions_++])
+      DynCallGraphNode::calledFunctionTy(child, it->count);
+
+    unsigned siteIdx = numMap_.find(child->getNum())->second;
+    CallSiteTimes &site = callSites_[siteIdx];
+    site.calls += it->count;
+    std::pair<double, uint64_t> &context =
+      contextTimes[std::make_pair(it->parent, siteIdx)];
+    context.first += child->getExTime();
+    context.second += it->count;
+
+    // few targets per call site, so search linearly
+    std::vector<CallTarget>::iterator target = site.targets.begin();
+    while (target != site.targets.end() && target->name != child->name_)
+      ++target;
+    if (target == site.targets.end())
+      target = site.targets.insert(target, CallTarget(child->name_));
+    target->calls += it->count;
+    target->exTime += child->getExTime();
+  }
+  for (ContextTimesTy::const_iterator it = contextTimes.begin(),
+        e = contextTimes.end(); it != e; ++it)
+    callSites_[it->first.second].times.add(it->second.first,
+                                           (double)it->second.second);
+
+  std::vector<PendingEdge>().swap(edges_);
+}
+
+bool DynCallGraph::linkInstruction(uint64_t num, Instruction* inst) {
+  DynNumMapTy::iterator site = numMap_.find(num);
+  if (site == numMap_.end())
     return false;
 
-  node->second->setInstruction(inst); // link node
-  instMap_[inst] = node->second;
+  DynCallGraphNode *node = callSites_[site->second].node;
+  node->setInstruction(inst); // link node
+  instMap_[inst] = node;
   return true;
 }
 
+unsigned DynCallGraph::linkInstructions(const CallSiteTable &table) {
+  unsigned linked = 0;
+  for (CallSiteTable::const_iterator it = table.begin(), e = table.end();
+       it != e; ++it)
+    if (linkInstruction(it->first, it->second))
+      ++linked;
+  return linked;
+}
+
 bool DynCallGraph::getConcreteName(Instruction *inst, std::string &name) const {
   DynInstMapTy::const_iterator node = instMap_.find(inst);
   if (node == instMap_.end())
@@ -78,7 +187,58 @@ double DynCallGraph::getExecutionTime(Instruction *inst) const {
     return node->second->getExTime();
 }
 
+double DynCallGraph::getExecutionTime(Instruction *inst, double q) const {
+  const CallSiteTimes *site = getCallSiteTimes(inst);
+  return site ? site->times.getQuantile(q) : 0.0;
+}
+
+double DynCallGraph::getMaxContextTime(Instruction *inst) const {
+  return getExecutionTime(inst, 1.0);
+}
+
+void DynCallGraph::getExecutionTimeBounds(Instruction *inst, double &lo,
+                                          double &hi) const {
+  getExecutionTimeBounds(inst, 1.0, lo, hi);
+}
+
+void DynCallGraph::getExecutionTimeBounds(Instruction *inst, double q,
+                                          double &lo, double &hi) const {
+  const CallSiteTimes *site = getCallSiteTimes(inst);
+  if (!site) {
+    lo = hi = 0.0;
+    return;
+  }
+
+  // the relative uncertainty of the mean of the representing context applies
+  // to the other contexts as well
+  double exTime = site->times.getQuantile(q);
+  double delta = exTime * site->node->getStat().getRelHalfWidth();
+  lo = std::max(0.0, exTime - delta);
+  hi = exTime + delta;
+}
+
+const CallSiteTimes *DynCallGraph::getCallSiteTimes(Instruction *inst) const {
+  DynInstMapTy::const_iterator node = instMap_.find(inst);
+  if (node == instMap_.end())
+    return 0;
+  return getCallSiteTimes(node->second->getNum());
+}
+
+const CallSiteTimes *DynCallGraph::getCallSiteTimes(uint64_t num) const {
+  DynNumMapTy::const_iterator site = numMap_.find(num);
+  return site != numMap_.end() ? &callSites_[site->second] : 0;
+}
+
+size_t DynCallGraph::getMemoryUsage() const {
+  return allocator_.getTotalMemory() +
+         nodes_.capacity() * sizeof(DynCallGraphNode*) +
+         idIndex_.capacity() * sizeof(DynCallGraphNode*) +
+         sparseIndex_.getMemorySize() +
+         edges_.capacity() * sizeof(PendingEdge) +
+         names_.getNumBuckets() * sizeof(void*) +
+         callSites_.capacity() * sizeof(CallSiteTimes) +
+         numMap_.getMemorySize() + instMap_.getMemorySize();
+}
+
 char DynCallGraph::ID = 0;
 const std::string DynCallGraph::FILENAME = "dyncallgraph.dot";
-double DynCallGraph::totExTime = 0.0;
-unsigned DynCallGraph::totNoCalls = 0;
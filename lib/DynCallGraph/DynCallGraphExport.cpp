@@ -0,0 +1,148 @@
+//===----- DynCallGraphExport.cpp - Graph export - Implementation ---------===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the graph-file and folded-stack exports and the self-time
+// report of dynamic call graphs.
+//
+//===----------------------------------------------------------------------===//
+#include "DynCallGraph/DynCallGraphExport.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <string>
+
+using namespace llvm;
+
+namespace {
+  /// A node on the path from the root to the current calling context.
+  struct Frame {
+    const DynCallGraphNode *node;
+    DynCallGraphNode::const_iterator next;  // the next child to visit
+    size_t prefixLen;                       // length of the parent's stack
+
+    Frame(const DynCallGraphNode *n, size_t len)
+      : node(n), next(n->begin()), prefixLen(len) { }
+  };
+
+  /// Orders entries by decreasing self time.
+  struct SelfTimeComp {
+    bool operator()(const SelfTimeEntry &lhs, const SelfTimeEntry &rhs) const {
+      return lhs.selfTime > rhs.selfTime;
+    }
+  };
+}
+
+void llvm::writeDynCallGraph(const DynCallGraph &graph, raw_ostream &out) {
+  out << "digraph \"Dynamic Call Graph\" {\n";
+  out << "\tlabel=\"Dynamic Call Graph\";\n\n";
+
+  // every node is followed by the edge from its parent
+  typedef std::pair<const DynCallGraphNode*, unsigned> CallTy;
+  std::vector<std::pair<const DynCallGraphNode*, CallTy> > stack;
+  if (const DynCallGraphNode *root = graph.getRoot())
+    stack.push_back(std::make_pair((const DynCallGraphNode*)0,
+                                   CallTy(root, 0)));
+  while (!stack.empty()) {
+    const DynCallGraphNode *parent = stack.back().first;
+    const DynCallGraphNode *node = stack.back().second.first;
+    unsigned count = stack.back().second.second;
+    stack.pop_back();
+
+    const RunningStat &stat = node->getStat();
+    out << "\tNode" << node->getID() << " [shape=record,label=\"{"
+        << node->getNameRef() << ';' << node->getNum() << ';'
+        << format("%f", node->getExTime()) << ';'
+        << format("%f", stat.getWeight()) << ';'
+        << format("%e", stat.getM2()) << "}\"];\n";
+    if (parent)
+      out << "\tNode" << parent->getID() << " -> Node" << node->getID()
+          << " [label=\"" << count << "\"];\n";
+
+    // the children are pushed in reverse, so they are written in order
+    for (DynCallGraphNode::const_iterator it = node->end();
+         it != node->begin(); ) {
+      --it;
+      stack.push_back(std::make_pair(node, CallTy(it->first, it->second)));
+    }
+  }
+  out << "}";
+}
+
+// writeStack - Writes a single line of the folded-stack format.
+static void writeStack(raw_ostream &out, const std::string &stack,
+                       const DynCallGraphNode *node) {
+  uint64_t selfTime = (uint64_t)(node->getSelfTime() + 0.5);
+  if (selfTime)
+    out << stack << ' ' << selfTime << '\n';
+}
+
+void llvm::writeFoldedStacks(const DynCallGraph &graph, raw_ostream &out) {
+  const DynCallGraphNode *root = graph.getRoot();
+  if (!root)
+    return;
+
+  // the stack string grows and shrinks with the path
+  std::string stack = root->getNameRef().str();
+  std::vector<Frame> path;
+  path.push_back(Frame(root, 0));
+  writeStack(out, stack, root);
+  while (!path.empty()) {
+    Frame &frame = path.back();
+    if (frame.next == frame.node->end()) {
+      stack.resize(frame.prefixLen);
+      path.pop_back();
+      continue;
+    }
+
+    const DynCallGraphNode *child = (frame.next++)->first;
+    size_t prefixLen = stack.size();
+    stack += ';';
+    stack.append(child->getNameRef().begin(), child->getNameRef().end());
+    writeStack(out, stack, child);
+    path.push_back(Frame(child, prefixLen));
+  }
+}
+
+void llvm::getTopSelfTimes(const DynCallGraph &graph, unsigned n,
+                           std::vector<SelfTimeEntry> &entries) {
+  entries.clear();
+
+  // sum up the contexts of each function
+  StringMap<unsigned> index;
+  for (DynCallGraph::const_iterator it = graph.begin(), e = graph.end();
+       it != e; ++it) {
+    StringMapEntry<unsigned> &entry =
+      index.GetOrCreateValue((*it)->getNameRef(), (unsigned)entries.size());
+    if (entry.getValue() == entries.size())
+      entries.push_back(SelfTimeEntry((*it)->getNameRef()));
+    SelfTimeEntry &self = entries[entry.getValue()];
+    self.selfTime += (*it)->getSelfTime();
+    ++self.contexts;
+  }
+
+  if (!n || n > entries.size())
+    n = entries.size();
+  std::partial_sort(entries.begin(), entries.begin() + n, entries.end(),
+                    SelfTimeComp());
+  entries.resize(n, SelfTimeEntry(StringRef()));
+}
+
+void llvm::printTopSelfTimes(const DynCallGraph &graph, unsigned n,
+                             raw_ostream &out) {
+  std::vector<SelfTimeEntry> entries;
+  getTopSelfTimes(graph, n, entries);
+
+  double totTime = graph.getTotExecutionTime();
+  out << "     self time       %  contexts  function\n";
+  for (std::vector<SelfTimeEntry>::const_iterator it = entries.begin(),
+        e = entries.end(); it != e; ++it)
+    out << format("%14.6f%8.2f%10u", it->selfTime,
+                  totTime > 0.0 ? it->selfTime / totTime * 100 : 0.0,
+                  it->contexts)
+        << "  " << it->name << '\n';
+}
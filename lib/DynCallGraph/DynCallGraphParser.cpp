@@ -4,92 +4,419 @@
 //
 //===----------------------------------------------------------------------===//
 //
-// This file defines the DynCallGraphParser pass.
+// This file defines the DynCallGraphParser pass. Several graph files (e.g. of
+// separate processes) are parsed in parallel and merged by calling context.
 //
 //===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "parpot-dyncallgraphreader"
 #include "DynCallGraph/DynCallGraphParser.h"
-#include <iostream>
-#include <fstream>
-#include <sstream>
+#include "DynCallGraph/DynCallGraphScanner.h"
+#include "Support/ThreadPool.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PathV2.h"
 #include "llvm/Support/raw_ostream.h"
-#include "llvm/Support/InstIterator.h"
-#include "llvm/Instructions.h"
-#include <assert.h>
-#include <set>
+#include "llvm/Support/system_error.h"
+#include "llvm/Support/Timer.h"
+
+#include <algorithm>
+#include <map>
 
 using namespace llvm;
 
-bool DynCallGraphParserPass::fillGraph(const char *filename) {
-  
-  // declarations
-  std::string line, node, succ, name, num, count, sExTime;
-  size_t pos, end;
-  unsigned nodeID = 0, succID = 0, number = 0, countNo;
-  double exTime;
-  
-  // open file
-  std::ifstream file(filename, std::ios::in);
-  if (!file) {
-      errs() << "Error: Can't open file " << filename << '\n';
-      return false;
+STATISTIC(NumNodesRead, "The # of dynamic call graph nodes read.");
+STATISTIC(NumEdgesRead, "The # of dynamic call graph edges read.");
+STATISTIC(NumFilesRead, "The # of dynamic call graph files read.");
+STATISTIC(NumContexts,  "The # of calling contexts after merging.");
+STATISTIC(NumColdSkipped, "The # of cold nodes skipped while reading.");
+
+static cl::list<std::string>
+DCGFiles("dcg-file",
+         cl::CommaSeparated,
+         cl::desc("Dynamic call graph file(s) to read "
+                  "(default = 'dyncallgraph.dot')"),
+         cl::value_desc("filename"));
+
+static cl::opt<std::string>
+DCGDir("dcg-dir",
+       cl::desc("Read all .dot files of a directory as dynamic call graphs"),
+       cl::value_desc("directory"));
+
+static cl::opt<unsigned>
+DCGThreads("dcg-threads",
+           cl::desc("Number of threads parsing dynamic call graph files "
+                    "(default = one per processor)"),
+           cl::init(0));
+
+static cl::opt<double>
+DCGMinFraction("dcg-min-fraction",
+               cl::desc("Skip subtrees of the dynamic call graph whose "
+                        "inclusive time is below this fraction of the total "
+                        "time (default = 0, read all)"),
+               cl::init(0.0));
+
+namespace {
+  /// The records of a single graph file. Node names point into the mapped
+  /// file, so it is kept until the graphs are merged.
+  struct ParsedGraph {
+    std::string filename;
+    double weight;    // of the run the file was written by
+    OwningPtr<MemoryBuffer> file;
+    std::vector<DynCallGraphScanner::Node> nodes;
+    std::vector<DynCallGraphScanner::Edge> edges;
+    unsigned skipped; // nodes of cold subtrees
+    bool valid;
+
+    ParsedGraph(const std::string &name, double w)
+      : filename(name), weight(w), skipped(0), valid(false) { }
+  };
+
+  typedef std::vector<ParsedGraph*> ParsedGraphsTy;
+
+  /// Parses each file of a list of graphs on its own.
+  class ParseGraphsTask : public ItemTask {
+    ParsedGraphsTy &graphs_;
+    double minFraction_;
+
+  public:
+    ParseGraphsTask(ParsedGraphsTy &graphs, double minFraction)
+      : graphs_(graphs), minFraction_(minFraction) { }
+
+    virtual void runItem(unsigned item);
+  };
+
+  /// A calling context of the merged graph.
+  struct MergedContext {
+    StringRef name;
+    uint64_t num;
+    unsigned parent;
+    double count;
+    double exTime;
+    RunningStat stat; // execution time per file
+
+    MergedContext(StringRef n, uint64_t nm, unsigned p)
+      : name(n), num(nm), parent(p), count(0.0), exTime(0.0) { }
+  };
+}
+
+// The status of scanning a graph file.
+enum ScanResult { ScanComplete, ScanFormatError, ScanEdgeError };
+
+// scanGraph - Passes the records of a graph file to sink, which provides
+// addNode(const Node&) and bool addEdge(const Edge&). With minFraction > 0
+// subtrees whose inclusive time is below that fraction of the root time are
+// skipped: the runtime writes the nodes in preorder, each followed by the edge
+// from its parent, so a node is held back until its edge shows whether the
+// parent was skipped.
+template<class SinkT>
+static ScanResult scanGraph(DynCallGraphScanner &scanner, double minFraction,
+                            SinkT &sink, unsigned &skipped) {
+  DynCallGraphScanner::Node node, pending;
+  DynCallGraphScanner::Edge edge;
+  bool seenRoot = false, hasPending = false;
+  double threshold = 0.0;
+  BitVector cold;
+  for (;;) {
+    switch (scanner.next(node, edge)) {
+    case DynCallGraphScanner::NodeRecord:
+      if (!seenRoot || minFraction <= 0.0) {
+        // the first node of a graph is its root (main)
+        if (!seenRoot)
+          threshold = minFraction * node.exTime;
+        seenRoot = true;
+        sink.addNode(node);
+        break;
+      }
+      if (hasPending) // a node without parent is kept
+        sink.addNode(pending);
+      pending = node;
+      hasPending = true;
+      break;
+
+    case DynCallGraphScanner::EdgeRecord:
+      if (hasPending && pending.id == edge.child) {
+        hasPending = false;
+        bool parentCold = edge.parent < cold.size() && cold[edge.parent];
+        if (parentCold || pending.exTime < threshold) {
+          if (edge.child >= cold.size())
+            cold.resize(std::max<unsigned>(edge.child + 1, 2 * cold.size()));
+          cold.set(edge.child);
+          ++skipped;
+          break;
+        }
+        sink.addNode(pending);
+      } else if (edge.parent < cold.size() && cold[edge.parent])
+        break;
+      if (!sink.addEdge(edge))
+        return ScanEdgeError;
+      break;
+
+    case DynCallGraphScanner::ErrorRecord:
+      return ScanFormatError;
+
+    case DynCallGraphScanner::EndOfFile:
+      if (hasPending)
+        sink.addNode(pending);
+      return ScanComplete;
+    }
   }
+}
+
+namespace {
+  /// Collects the records of a file for merging.
+  struct CollectSink {
+    ParsedGraph &graph;
+
+    explicit CollectSink(ParsedGraph &g) : graph(g) { }
+
+    void addNode(const DynCallGraphScanner::Node &node) {
+      graph.nodes.push_back(node);
+    }
+    bool addEdge(const DynCallGraphScanner::Edge &edge) {
+      graph.edges.push_back(edge);
+      return true;
+    }
+  };
+
+  /// Adds the records of a file to a graph.
+  struct GraphSink {
+    DynCallGraph &graph;
+
+    explicit GraphSink(DynCallGraph &g) : graph(g) { }
+
+    void addNode(const DynCallGraphScanner::Node &node) {
+      // merged graphs carry the statistics of their runs
+      RunningStat stat;
+      if (node.weight > 0.0)
+        stat = RunningStat(node.weight, node.exTime / node.weight, node.m2);
+      graph.addNode(node.id, node.name, node.num, node.exTime, stat);
+      ++NumNodesRead;
+    }
+    bool addEdge(const DynCallGraphScanner::Edge &edge) {
+      ++NumEdgesRead;
+      return graph.addEdge(edge.parent, edge.child, edge.count);
+    }
+  };
+}
+
+// Errors are printed by the merging thread, so workers only record them.
+void ParseGraphsTask::runItem(unsigned item) {
+  ParsedGraph &graph = *graphs_[item];
+  if (MemoryBuffer::getFile(graph.filename, graph.file))
+    return;
+
+  DynCallGraphScanner scanner(graph.file->getBufferStart(),
+                              graph.file->getBufferEnd());
+  CollectSink sink(graph);
+  graph.valid = scanGraph(scanner, minFraction_, sink, graph.skipped) ==
+                ScanComplete;
+}
 
-  // read file line by line
-  while(file) {
-    line.clear();
-    if (!getline(file, line)) break; // file completely read
-
-    if (line.compare(0, 5, "\tNode") == 0) {
-      end = line.find(" ", 5);
-      node = line.substr(5, end - 5); // get node number
-      std::stringstream sNodeID(node);
-      sNodeID >> nodeID;
-
-      // add nodes
-      if ((pos = line.find("\"{", 0)) != std::string::npos) {
-        pos += 2; // shift by 2 chars to begin of label
-        end = line.find(";", pos);
-        name = line.substr(pos, end - pos);
-        pos = end + 1;
-        end = line.find(";", pos);
-        num = line.substr(pos, end - pos);
-        std::stringstream sNum(num);
-        sNum >> number;
-        pos = end + 1;
-        end = line.find("}", pos);
-        sExTime = line.substr(pos, end - pos);
-        std::stringstream sTime(sExTime);
-        sTime >> exTime;
-        addNode(nodeID, name, number, exTime);
+// getNodeStat - Returns the time statistics of a node record of a file with
+// the given weight; a node of an unmerged graph is a single sample.
+static RunningStat getNodeStat(const DynCallGraphScanner::Node &node,
+                               double weight) {
+  if (node.weight > 0.0)
+    return RunningStat(weight * node.weight, node.exTime / node.weight,
+                       weight * node.m2);
+  return RunningStat(weight, node.exTime, 0.0);
+}
+
+// fillGraph - Adds the nodes and edges of a single file to graph.
+static bool fillGraph(const std::string &filename, DynCallGraph &graph,
+                      double minFraction) {
+
+  // map the file into memory
+  OwningPtr<MemoryBuffer> file;
+  if (error_code ec = MemoryBuffer::getFile(filename, file)) {
+    errs() << "Error: Can't open file " << filename << ": " << ec.message()
+           << '\n';
+    return false;
+  }
+
+  // scan the records in place
+  DynCallGraphScanner scanner(file->getBufferStart(), file->getBufferEnd());
+  GraphSink sink(graph);
+  unsigned skipped = 0;
+  ScanResult result = scanGraph(scanner, minFraction, sink, skipped);
+  NumColdSkipped += skipped;
+  switch (result) {
+  case ScanEdgeError:
+    errs() << "Error: Can't create edge in " << filename << ", line "
+           << scanner.getLine() << ". Node doesn't exist!\n";
+    return false;
+  case ScanFormatError:
+    errs() << "Error: Wrong file format in " << filename << ", line "
+           << scanner.getLine() << '\n';
+    return false;
+  default:
+    return true;
+  }
+}
+
+// mergeGraphs - Merges equivalent calling contexts of the parsed graphs, i.e.
+// the children of a merged context with the same call-site ID and target,
+// into graph. Times and call counts are weighted by the weight of each file.
+static bool mergeGraphs(const ParsedGraphsTy &graphs, DynCallGraph &graph) {
+  typedef std::pair<std::pair<unsigned, uint64_t>, StringRef> ContextKeyTy;
+  std::vector<MergedContext> contexts;
+  std::map<ContextKeyTy, unsigned> contextMap;
+  double totWeight = 0.0;
+  for (ParsedGraphsTy::const_iterator gi = graphs.begin(), ge = graphs.end();
+       gi != ge; ++gi) {
+    ParsedGraph *g = *gi;
+    if (!g->file) {
+      errs() << "WARNING: Can't open file " << g->filename << '\n';
+      continue;
+    }
+    if (!g->valid || g->nodes.empty()) {
+      errs() << "WARNING: Wrong file format in " << g->filename
+             << " - file ignored.\n";
+      continue;
+    }
+    ++NumFilesRead;
+    NumColdSkipped += g->skipped;
+    NumNodesRead += g->nodes.size();
+    NumEdgesRead += g->edges.size();
+
+    std::map<unsigned, const DynCallGraphScanner::Node*> nodes;
+    for (unsigned i = 1, e = g->nodes.size(); i < e; ++i)
+      nodes[g->nodes[i].id] = &g->nodes[i];
+
+    // the first node of a graph is its root (main)
+    const DynCallGraphScanner::Node &root = g->nodes.front();
+    if (contexts.empty())
+      contexts.push_back(MergedContext(root.name, root.num, 0));
+    RunningStat rootStat = getNodeStat(root, g->weight);
+    contexts[0].exTime += g->weight * root.exTime;
+    contexts[0].stat.merge(rootStat);
+    totWeight += rootStat.getWeight();
+
+    std::map<unsigned, unsigned> merged; // node id of the file -> context
+    merged[root.id] = 0;
+    for (std::vector<DynCallGraphScanner::Edge>::const_iterator
+          edge = g->edges.begin(), ee = g->edges.end(); edge != ee; ++edge) {
+      std::map<unsigned, const DynCallGraphScanner::Node*>::iterator child =
+        nodes.find(edge->child);
+      std::map<unsigned, unsigned>::iterator parent =
+        merged.find(edge->parent);
+      if (child == nodes.end() || parent == merged.end()) {
+        errs() << "Error: Can't create edge in " << g->filename
+               << ". Node doesn't exist!\n";
+        return false;
       }
 
-      // add edges
-      if ((pos = line.find("->", 0)) != std::string::npos) {
-        pos += 7; // shift by 7 chars to begin of succ-node
-        end = line.find(" ", pos);
-        succ = line.substr(pos, end - pos);
-        assert((pos = line.find("label", end)) != std::string::npos
-            && "Wrong file format!");
-        pos += 7;
-        end = line.find("\"", pos);
-        count = line.substr(pos, end - pos);
-
-        std::stringstream sCount(count);
-        sCount >> countNo;
-        std::stringstream sSucc(succ);
-        sSucc >> succID;
-        assert(addEdge(nodeID, succID, countNo)
-            && "Can't create edge in dyncallgraph. Edge doesn't exist!");
+      const DynCallGraphScanner::Node &node = *child->second;
+      ContextKeyTy key(std::make_pair(parent->second, node.num), node.name);
+      std::map<ContextKeyTy, unsigned>::iterator ctx = contextMap.find(key);
+      if (ctx == contextMap.end()) {
+        ctx = contextMap.insert(std::make_pair(key, contexts.size())).first;
+        contexts.push_back(MergedContext(node.name, node.num, parent->second));
       }
+      MergedContext &context = contexts[ctx->second];
+      context.count += g->weight * edge->count;
+      context.exTime += g->weight * node.exTime;
+      context.stat.merge(getNodeStat(node, g->weight));
+      merged[edge->child] = ctx->second;
     }
   }
 
+  if (contexts.empty())
+    return false;
+  NumContexts += contexts.size();
+
+  // contexts precede their children, so nodes and edges can be added in order;
+  // files lacking a context contribute zero samples
+  for (unsigned i = 0, e = contexts.size(); i != e; ++i) {
+    MergedContext &context = contexts[i];
+    context.stat.add(0.0, totWeight - context.stat.getWeight());
+    graph.addNode(i + 1, context.name, context.num, context.exTime,
+                  context.stat);
+    if (i)
+      graph.addEdge(context.parent + 1, i + 1,
+                    (unsigned)(context.count + 0.5));
+  }
   return true;
 }
 
+bool llvm::readDynCallGraph(const std::string &filename, DynCallGraph &graph,
+                            double minFraction) {
+  bool read = fillGraph(filename, graph, minFraction);
+  graph.finalize();
+  return read;
+}
+
+bool llvm::readDynCallGraphs(const std::vector<std::string> &filenames,
+                             DynCallGraph &graph, unsigned threads,
+                             double minFraction) {
+  if (filenames.size() == 1)
+    return readDynCallGraph(filenames.front(), graph, minFraction);
+
+  std::vector<double> weights(filenames.size(), 1.0);
+  return readDynCallGraphs(filenames, weights, graph, threads, minFraction);
+}
+
+bool llvm::readDynCallGraphs(const std::vector<std::string> &filenames,
+                             const std::vector<double> &weights,
+                             DynCallGraph &graph, unsigned threads,
+                             double minFraction) {
+  assert(filenames.size() == weights.size() && "A weight per file needed!");
+
+  // parse all files in parallel, then merge them in the given order
+  ParsedGraphsTy graphs;
+  for (unsigned i = 0, e = filenames.size(); i != e; ++i)
+    graphs.push_back(new ParsedGraph(filenames[i], weights[i]));
+  ParseGraphsTask task(graphs, minFraction);
+  ThreadPool pool(threads);
+  pool.run(task, graphs.size());
+
+  bool merged = mergeGraphs(graphs, graph);
+  DeleteContainerPointers(graphs);
+  graph.finalize();
+  return merged;
+}
+
+// getGraphFiles - Returns the graph files given by the options.
+static void getGraphFiles(std::vector<std::string> &filenames) {
+  filenames.assign(DCGFiles.begin(), DCGFiles.end());
+
+  if (!DCGDir.empty()) {
+    std::vector<std::string> dirFiles;
+    error_code ec;
+    for (sys::fs::directory_iterator it(Twine(DCGDir), ec), e;
+         !ec && it != e; it.increment(ec))
+      if (sys::path::extension(it->path()) == ".dot")
+        dirFiles.push_back(it->path());
+    if (ec)
+      errs() << "WARNING: Can't read directory " << DCGDir << ": "
+             << ec.message() << '\n';
+    std::sort(dirFiles.begin(), dirFiles.end());
+    filenames.insert(filenames.end(), dirFiles.begin(), dirFiles.end());
+  }
+
+  if (filenames.empty())
+    filenames.push_back("dyncallgraph.dot");
+}
+
 bool DynCallGraphParserPass::runOnModule(Module &M) {
-  fillGraph("dyncallgraph.dot");
+  std::vector<std::string> filenames;
+  getGraphFiles(filenames);
+
+  TimeRecord start = TimeRecord::getCurrentTime(true);
+  readDynCallGraphs(filenames, *this, DCGThreads, DCGMinFraction);
+  TimeRecord loadTime = TimeRecord::getCurrentTime(false);
+  loadTime -= start;
+
+  DEBUG(dbgs() << "Loaded dynamic call graph: " << size() << " nodes, "
+               << getTotNoCalls() << " calls in "
+               << format("%.3f", loadTime.getWallTime()) << "s, "
+               << getMemoryUsage() / 1024 << " KB\n");
 
   // retrieve main function
   Function *Main = M.getFunction("main");
@@ -98,17 +425,9 @@ bool DynCallGraphParserPass::runOnModule(Module &M) {
     return false;
   }
 
-  // find each call-/invoke-instruction and create link
-  unsigned int i = 1; // 0 is for main function
-  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F)
-  	if (!F->isDeclaration())
-
-      // add notify-call instructions
-      for (inst_iterator it = inst_begin(F), e = inst_end(F); it != e; ++it)
-      	if (isa<CallInst>(&*it) || isa<InvokeInst>(&*it)) {
-      		linkInstruction(i, &*it); // link instruction to dyncallgraph node
-      		i++; // increment function count
-      	}
+  // link the call sites by their IDs
+  CallSiteTable table(M);
+  linkInstructions(table);
 
   return false;
 }
@@ -0,0 +1,50 @@
+//===- CallSiteIDs.cpp - Assign module-qualified call-site IDs ------------===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass records a module-qualified ID for every call site of the module
+// as metadata (see CallSiteID.h). Running it on each module before linking
+// keeps the IDs of the instrumented and the analyzed program consistent,
+// independent of the order in which the modules are linked.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "parpot-callsite-ids"
+#include "DynCallGraph/CallSiteID.h"
+#include "Instrumentation/Instrumentation.h"
+#include "llvm/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/ADT/Statistic.h"
+#include <vector>
+using namespace llvm;
+
+STATISTIC(NumCallSites, "The # of call sites with an ID.");
+
+namespace {
+  class CallSiteIDs : public ModulePass {
+    bool runOnModule(Module &M);
+  public:
+    static char ID; // Pass identification, replacement for typeid
+    CallSiteIDs() : ModulePass(ID) {}
+
+    virtual const char *getPassName() const {
+      return "Call-site ID assignment";
+    }
+  };
+}
+
+char CallSiteIDs::ID = 0;
+static RegisterPass<CallSiteIDs>
+X("parpot-callsite-ids", "Assign module-qualified IDs to call sites");
+
+ModulePass *llvm::createCallSiteIDPass() {
+  return new CallSiteIDs();
+}
+
+bool CallSiteIDs::runOnModule(Module &M) {
+  std::vector<CallSiteIDEntry> callSites;
+  collectCallSiteIDs(M, callSites, /*assign*/ true);
+  NumCallSites += callSites.size();
+  return !callSites.empty();
+}
@@ -12,6 +12,7 @@
 #define DEBUG_TYPE "insert-callgraph-instructions"
 
 #include "Instrumentation/DynCallGraphInsUtils.h"
+#include "DynCallGraph/CallSiteID.h"
 #include "llvm/Module.h"
 #include "llvm/Pass.h"
 #include "llvm/Constants.h"
@@ -24,6 +25,7 @@
 #include "llvm/Instructions.h"
 #include <set>
 #include <map>
+#include <vector>
 using namespace llvm;
 
 namespace {
@@ -33,6 +35,8 @@ namespace {
   class DynCallGraphIns : public ModulePass {
     bool runOnModule(Module &M);
   private:
+    std::map<std::string, GlobalVariable*> globalVars_; // names of this module
+
     GlobalVariable* getGV(Module &mod, LLVMContext &context, StringRef str);
   public:
     static char ID; // Pass identification, replacement for typeid
@@ -55,65 +59,55 @@ ModulePass *llvm::createDynCallGraphPass() {
 
 GlobalVariable* DynCallGraphIns::getGV(Module &mod, LLVMContext &context,
     StringRef str) {
-  static std::map<StringRef, GlobalVariable*> globalVars;
-
   // check if global variable already exist
-  if (globalVars.find(str) != globalVars.end())
-    return globalVars.find(str)->second;
+  std::map<std::string, GlobalVariable*>::iterator it = globalVars_.find(str);
+  if (it != globalVars_.end())
+    return it->second;
 
   // add global variable with function name
   Constant *msg_0 = ConstantArray::get(context, str);
   GlobalVariable *fnc = new GlobalVariable(
     mod, msg_0->getType(), true, GlobalValue::InternalLinkage, msg_0, "fnc");
-  globalVars[str] = fnc;
+  globalVars_[str] = fnc;
   return fnc;
 }
 
 bool DynCallGraphIns::runOnModule(Module &M) {
 
-  // retrieve main function
-  Function *Main = M.getFunction("main");
-  if (Main == 0) {
-    errs() << "WARNING: cannot insert call graph instrumentation into a module"
-           << " with no main function!\n";
-    return false;  // No main, no instrumentation!
-  }
+  globalVars_.clear();
+
+  // assign module-qualified IDs to all call sites that have none yet
+  std::vector<CallSiteIDEntry> callSites;
+  collectCallSiteIDs(M, callSites, /*assign*/ true);
 
   // instrument every call / invoke instruction
-  unsigned int i = 1; // 0 is for main function
+  for (std::vector<CallSiteIDEntry>::iterator it = callSites.begin(),
+        e = callSites.end(); it != e; ++it) {
+    CallSite cs(it->second);
+    Function *f = cs.getCalledFunction();
+    GlobalVariable *gv;
+    if (f) {
+      gv = getGV(M, M.getContext(), f->getName());
+    } else {
+      gv = getGV(M, M.getContext(), "ext");
+    }
+    addNotifyCall(&cs, it->second->getParent(), "llvm_call_instruction",
+        "llvm_call_finished_instruction", gv, it->first);
+  }
+
+  // add function called - call
   for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F) {
-  	if (!F->isDeclaration()) {
-  		// add notify-call instructions
-			for (inst_iterator it = inst_begin(F), e = inst_end(F); it != e; ++it) {
-				CallSite *pCS;
-				if (CallInst *callInst = dyn_cast<CallInst>(&*it))
-					pCS = new CallSite(callInst);
-				else if (InvokeInst *invokeInst = dyn_cast<InvokeInst>(&*it))
-					pCS = new CallSite(invokeInst);
-				else
-					continue;
-
-				Function *f = pCS->getCalledFunction();
-				GlobalVariable *gv;
-				if (f && f->getNameStr() == "llvm_call_finished_instruction")
-					continue;
-				if (f) {
-					gv = getGV(M, F->getContext(), f->getName());
-				} else {
-					gv = getGV(M, F->getContext(), "ext");
-				}
-				addNotifyCall(pCS , it->getParent(), "llvm_call_instruction",
-						"llvm_call_finished_instruction", gv, i);
-
-				i++; // increment function counter
-				delete pCS;
-			}
-
-			// add function called - call
-			GlobalVariable *gv = getGV(M, F->getContext(), F->getName());
-			addNotifyFnCalled(&*F, "llvm_function_called", gv);
-		}
-	}
+    if (!F->isDeclaration()) {
+      GlobalVariable *gv = getGV(M, F->getContext(), F->getName());
+      addNotifyFnCalled(&*F, "llvm_function_called", gv);
+    }
+  }
+
+  // modules without main are linked to the main module later on; they don't
+  // need the runtime initialization
+  Function *Main = M.getFunction("main");
+  if (Main == 0 || Main->isDeclaration())
+    return true;
 
   // Add the initialization call to main.
   insertPrepareCallGraph(Main, "llvm_build_and_write_dyncallgraph");
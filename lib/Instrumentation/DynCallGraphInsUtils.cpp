@@ -31,7 +31,7 @@ void llvm::insertPrepareCallGraph(Function *mainFn, const char *fnName) {
 
   Type *ArgVTy = PointerType::getUnqual(Type::getInt8PtrTy(context));
   Module &M = *mainFn->getParent();
-  Constant *InitFn = M.getOrInsertFunction(fnName, Type::getVoidTy(context),
+  Constant *InitFn = M.getOrInsertFunction(fnName, Type::getInt32Ty(context),
                                            Type::getInt32Ty(context),
                                            ArgVTy, (Type *)0);
   // This could force argc and argv into programs that wouldn't otherwise have
@@ -40,7 +40,7 @@ void llvm::insertPrepareCallGraph(Function *mainFn, const char *fnName) {
   Args[0] = Constant::getNullValue(Type::getInt32Ty(context));
   Args[1] = Constant::getNullValue(ArgVTy);
 
-   CallInst *InitCall = CallInst::Create(InitFn, Args, "", insertPos);
+   CallInst *InitCall = CallInst::Create(InitFn, Args, "newargc", insertPos);
 
   // If argc or argv are not available in main, just pass null values in.
   Function::arg_iterator AI;
@@ -64,14 +64,18 @@ void llvm::insertPrepareCallGraph(Function *mainFn, const char *fnName) {
     // init call instead.
     if (!AI->getType()->isIntegerTy(32)) {
       Instruction::CastOps opcode;
-      opcode = CastInst::getCastOpcode(AI, true, AI->getType(), true);
-      AI->replaceAllUsesWith(
-      		CastInst::Create(opcode, InitCall, AI->getType(), "", insertPos));
+      if (!AI->use_empty()) {
+        opcode = CastInst::getCastOpcode(InitCall, true, AI->getType(), true);
+        AI->replaceAllUsesWith(
+        		CastInst::Create(opcode, InitCall, AI->getType(), "", insertPos));
+      }
+      opcode = CastInst::getCastOpcode(AI, true,
+                                       Type::getInt32Ty(context), true);
       InitCall->setArgOperand(0,
           CastInst::Create(opcode, AI, Type::getInt32Ty(context),
                            "argc.cast", InitCall));
     } else {
-//      AI->replaceAllUsesWith(InitCall);
+      AI->replaceAllUsesWith(InitCall);
     	InitCall->setArgOperand(0, AI);
     }
 
@@ -80,7 +84,7 @@ void llvm::insertPrepareCallGraph(Function *mainFn, const char *fnName) {
 }
 
 void llvm::addNotifyCall(CallSite *cs, BasicBlock *bb, const char *fnNameBefore,
-    const char *fnNameAfter, GlobalVariable *gv, unsigned fnNum) {
+    const char *fnNameAfter, GlobalVariable *gv, uint64_t fnNum) {
   // get corresponding module and context
   Module &mod = *bb->getParent()->getParent();
   LLVMContext &context = bb->getContext();
@@ -94,7 +98,7 @@ void llvm::addNotifyCall(CallSite *cs, BasicBlock *bb, const char *fnNameBefore,
     const Type *Int8Ptr = PointerType::getUnqual(IntegerType::getInt8Ty(context));
     Constant *callFn = mod.getOrInsertFunction(fnNameBefore,
                                   Type::getVoidTy(context),
-                                  Int8Ptr, Type::getInt32Ty(context),
+                                  Int8Ptr, Type::getInt64Ty(context),
                                   (Type *)0);
 
     Constant *zero = Constant::getNullValue(IntegerType::getInt32Ty(context));
@@ -106,7 +110,7 @@ void llvm::addNotifyCall(CallSite *cs, BasicBlock *bb, const char *fnNameBefore,
 
     std::vector<Value*> Args(2);
     Args[0] = ConstantExpr::getGetElementPtr(gv, gep_params, 2);
-    Args[1] = ConstantInt::get(Type::getInt32Ty(context), fnNum);
+    Args[1] = ConstantInt::get(Type::getInt64Ty(context), fnNum);
 
     CallInst::Create(callFn, makeArrayRef(Args), "", insertPos);
   }
@@ -117,7 +121,7 @@ void llvm::addNotifyCall(CallSite *cs, BasicBlock *bb, const char *fnNameBefore,
     const Type *Int8Ptr = PointerType::getUnqual(IntegerType::getInt8Ty(context));
     Constant *callFn = mod.getOrInsertFunction(fnNameAfter,
                                   Type::getVoidTy(context),
-                                  Int8Ptr, Type::getInt32Ty(context),
+                                  Int8Ptr, Type::getInt64Ty(context),
                                   (Type *)0);
 
     Constant *zero = Constant::getNullValue(IntegerType::getInt32Ty(context));
@@ -129,7 +133,7 @@ void llvm::addNotifyCall(CallSite *cs, BasicBlock *bb, const char *fnNameBefore,
 
     std::vector<Value*> Args(2);
     Args[0] = ConstantExpr::getGetElementPtr(gv, gep_params, 2);
-    Args[1] = ConstantInt::get(Type::getInt32Ty(context), fnNum);
+    Args[1] = ConstantInt::get(Type::getInt64Ty(context), fnNum);
 
     if (cs->isInvoke()) {
       InvokeInst *invokeInst = dyn_cast<InvokeInst>(cs->getInstruction());
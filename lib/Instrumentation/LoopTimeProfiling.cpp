@@ -0,0 +1,247 @@
+//===- LoopTimeProfiling.cpp - Insert timers for loop time profiling ------===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass instruments the natural loops of the specified program for loop
+// time profiling. Every loop gets calls into the runtime when it is entered,
+// at the beginning of every iteration (loop header) and when it is left, so
+// the runtime can measure trip counts and the distribution of iteration times.
+// Loops left by an exception are closed at the next landing pad: functions
+// with landing pads note the depth of the runtime's loop stack on entry and
+// unwind the stack to it, plus the loops around the landing pad.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "insert-ltime-profiling"
+#include "Analysis/LoopTimeInfo.h"
+#include "Analysis/TimeProfileInfoTypes.h"
+#include "Instrumentation/Instrumentation.h"
+#include "Instrumentation/TimeProfilingUtils.h"
+#include "llvm/Constants.h"
+#include "llvm/DerivedTypes.h"
+#include "llvm/Instructions.h"
+#include "llvm/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include <vector>
+using namespace llvm;
+
+STATISTIC(NumLoopsInstrumented, "The # of loops instrumented.");
+STATISTIC(NumEdgesSkipped, "The # of loop edges that couldn't be split.");
+
+namespace {
+  /// A CFG edge that enters or leaves loops.
+  struct LoopEdge {
+    TerminatorInst *TI;
+    unsigned SuccNum;
+    std::vector<unsigned> Exits;  // left loops, innermost first
+    int Enter;                    // entered loop or -1
+
+    LoopEdge(TerminatorInst *ti, unsigned succ)
+      : TI(ti), SuccNum(succ), Enter(-1) { }
+  };
+
+  class LoopTimeProfiler : public ModulePass {
+    bool runOnModule(Module &M);
+
+    Constant *EnterFn, *IterationFn, *ExitFn, *DepthFn, *UnwindFn;
+
+    void instrumentFunction(Function &F, LoopInfo &LI,
+                            DenseMap<Loop*, unsigned> &ids);
+    void insertCalls(Constant *Fn, const std::vector<unsigned> &ids,
+                     Instruction *InsertPos);
+  public:
+    static char ID; // Pass identification, replacement for typeid
+    LoopTimeProfiler() : ModulePass(ID) {}
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.addRequired<LoopInfo>();
+    }
+
+    virtual const char *getPassName() const {
+      return "Loop Time Profiler";
+    }
+  };
+}
+
+char LoopTimeProfiler::ID = 0;
+static RegisterPass<LoopTimeProfiler>
+X("insert-ltime-profiling", "Insert instrumentation for loop time profiling");
+
+ModulePass *llvm::createLTimeProfilerPass() {
+  return new LoopTimeProfiler();
+}
+
+bool LoopTimeProfiler::runOnModule(Module &M) {
+  Function *Main = M.getFunction("main");
+  if (Main == 0) {
+    errs() << "WARNING: cannot insert loop profiling into a module"
+           << " with no main function!\n";
+    return false;  // No main, no instrumentation!
+  }
+
+  LLVMContext &Context = M.getContext();
+  Type *VoidTy = Type::getVoidTy(Context);
+  Type *Int32Ty = Type::getInt32Ty(Context);
+  EnterFn = M.getOrInsertFunction("llvm_loop_enter", VoidTy, Int32Ty,
+                                  (Type *)0);
+  IterationFn = M.getOrInsertFunction("llvm_loop_iteration", VoidTy, Int32Ty,
+                                      (Type *)0);
+  ExitFn = M.getOrInsertFunction("llvm_loop_exit", VoidTy, Int32Ty,
+                                 (Type *)0);
+  DepthFn = M.getOrInsertFunction("llvm_loop_depth", Int32Ty, (Type *)0);
+  UnwindFn = M.getOrInsertFunction("llvm_loop_unwind", VoidTy, Int32Ty,
+                                   (Type *)0);
+
+  // number the loops of all functions in module order before the CFG changes
+  std::vector<Function*> functions;
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F)
+    if (!F->isDeclaration())
+      functions.push_back(F);
+
+  unsigned NumLoops = 0;
+  for (std::vector<Function*>::iterator F = functions.begin(),
+        E = functions.end(); F != E; ++F) {
+    LoopInfo &LI = getAnalysis<LoopInfo>(**F);
+    std::vector<Loop*> loops;
+    getProfiledLoops(LI, loops);
+
+    // exceptions may pass functions without loops, so their landing pads
+    // close the loops of the callees as well
+    bool hasLandingPad = false;
+    for (Function::iterator BB = (*F)->begin(), E = (*F)->end();
+         BB != E && !hasLandingPad; ++BB)
+      hasLandingPad = BB->isLandingPad();
+    if (loops.empty() && !hasLandingPad) continue;
+
+    DenseMap<Loop*, unsigned> ids;
+    for (std::vector<Loop*>::iterator it = loops.begin(), e = loops.end();
+          it != e; ++it)
+      ids[*it] = NumLoops++;
+    instrumentFunction(**F, LI, ids);
+  }
+  NumLoopsInstrumented = NumLoops;
+
+  Type *ATy = ArrayType::get(Type::getDoubleTy(Context),
+                             NumLoops * LoopRecordSize);
+  GlobalVariable *Records =
+    new GlobalVariable(M, ATy, false, GlobalValue::InternalLinkage,
+                       Constant::getNullValue(ATy), "LoopProfRecords");
+
+  // Add the initialization call to main.
+  InsertTimeProfilingInitCall(Main, "llvm_start_ltime_profiling", Records);
+  return true;
+}
+
+void LoopTimeProfiler::insertCalls(Constant *Fn,
+                                   const std::vector<unsigned> &ids,
+                                   Instruction *InsertPos) {
+  Type *Int32Ty = Type::getInt32Ty(Fn->getContext());
+  for (std::vector<unsigned>::const_iterator it = ids.begin(), e = ids.end();
+        it != e; ++it)
+    CallInst::Create(Fn, ConstantInt::get(Int32Ty, *it), "", InsertPos);
+}
+
+void LoopTimeProfiler::instrumentFunction(Function &F, LoopInfo &LI,
+                                          DenseMap<Loop*, unsigned> &ids) {
+  std::vector<LoopEdge> edges;
+  std::vector<std::pair<TerminatorInst*, std::vector<unsigned> > > returns;
+  std::vector<std::pair<BasicBlock*, unsigned> > headers;
+  std::vector<std::pair<BasicBlock*, unsigned> > landingPads;
+
+  // collect all events on the unmodified CFG; splitting edges invalidates
+  // the loop information
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    Loop *SrcLoop = LI.getLoopFor(BB);
+    TerminatorInst *TI = BB->getTerminator();
+
+    if (SrcLoop && SrcLoop->getHeader() == BB)
+      headers.push_back(std::make_pair(BB, ids[SrcLoop]));
+
+    // the predecessors of a landing pad are within all loops around it, so
+    // these loops stay active
+    if (BB->isLandingPad())
+      landingPads.push_back(std::make_pair(BB, LI.getLoopDepth(BB)));
+
+    // returns and resumes leave all loops around them
+    if (isa<ReturnInst>(TI) || isa<ResumeInst>(TI)) {
+      std::vector<unsigned> exits;
+      for (Loop *L = SrcLoop; L; L = L->getParentLoop())
+        exits.push_back(ids[L]);
+      if (!exits.empty())
+        returns.push_back(std::make_pair(TI, exits));
+      continue;
+    }
+
+    for (unsigned i = 0, e = TI->getNumSuccessors(); i != e; ++i) {
+      BasicBlock *Dst = TI->getSuccessor(i);
+
+      // the landing pad unwinds the loops left by the exception
+      if (Dst->isLandingPad())
+        continue;
+
+      LoopEdge edge(TI, i);
+      for (Loop *L = SrcLoop; L && !L->contains(Dst); L = L->getParentLoop())
+        edge.Exits.push_back(ids[L]);
+
+      Loop *DstLoop = LI.getLoopFor(Dst);
+      if (DstLoop && DstLoop->getHeader() == Dst && !DstLoop->contains(BB))
+        edge.Enter = ids[DstLoop];
+
+      if (!edge.Exits.empty() || edge.Enter != -1)
+        edges.push_back(edge);
+    }
+  }
+
+  // instrument the edges; exits of the left loops precede the entry
+  for (std::vector<LoopEdge>::iterator it = edges.begin(), e = edges.end();
+        it != e; ++it) {
+    BasicBlock *Dst = it->TI->getSuccessor(it->SuccNum);
+    Instruction *InsertPos;
+    if (it->TI->getNumSuccessors() == 1)
+      InsertPos = it->TI;
+    else if (Dst->getSinglePredecessor())
+      InsertPos = Dst->getFirstInsertionPt();
+    else if (!isa<IndirectBrInst>(it->TI)) {
+      BasicBlock *NewBB = SplitCriticalEdge(it->TI, it->SuccNum);
+      InsertPos = NewBB->getTerminator();
+    } else {
+      ++NumEdgesSkipped;
+      continue;
+    }
+
+    insertCalls(ExitFn, it->Exits, InsertPos);
+    if (it->Enter != -1)
+      insertCalls(EnterFn, std::vector<unsigned>(1, it->Enter), InsertPos);
+  }
+
+  for (unsigned i = 0, e = returns.size(); i != e; ++i)
+    insertCalls(ExitFn, returns[i].second, returns[i].first);
+
+  // every iteration starts at the loop header
+  for (unsigned i = 0, e = headers.size(); i != e; ++i)
+    insertCalls(IterationFn, std::vector<unsigned>(1, headers[i].second),
+                headers[i].first->getFirstInsertionPt());
+
+  if (landingPads.empty())
+    return;
+
+  // the depth of the loop stack on entry dominates all landing pads
+  BasicBlock &Entry = F.getEntryBlock();
+  Instruction *Depth = CallInst::Create(DepthFn, "loopdepth",
+                                        Entry.getFirstInsertionPt());
+  for (unsigned i = 0, e = landingPads.size(); i != e; ++i) {
+    Instruction *InsertPos = landingPads[i].first->getFirstInsertionPt();
+    Value *Target = Depth;
+    if (landingPads[i].second)
+      Target = BinaryOperator::CreateAdd(Depth,
+                 ConstantInt::get(Depth->getType(), landingPads[i].second),
+                 "", InsertPos);
+    CallInst::Create(UnwindFn, Target, "", InsertPos);
+  }
+}
@@ -78,8 +78,8 @@ int save_arguments(int argc, const char **argv) {
  * multiple different kinds of instrumentation.  For this reason, this function
  * may be called more than once.
  */
-void write_profiling_data_d(double *Start,
-                          unsigned NumElements) {
+void write_profiling_data_d(enum TimeProfilingType PT, double *Start,
+                            unsigned NumElements) {
 
   static int OutFile = -1;
   int PTy;
@@ -110,7 +110,7 @@ void write_profiling_data_d(double *Start,
   }
 
   /* Write out this record! */
-  PTy = 8;
+  PTy = PT;
   write(OutFile, &PTy, sizeof(int));
   write(OutFile, &NumElements, sizeof(unsigned));
   write(OutFile, Start, NumElements*sizeof(double));
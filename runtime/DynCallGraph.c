@@ -84,17 +84,18 @@ void llvm_function_called(char* fnName, unsigned fnNum) {
     changeCurrentFunctionName(&graph, fnName);
 }
 
-void llvm_call_instruction(char* callOp, unsigned ownFnNum) {
+void llvm_call_instruction(char* callOp, uint64_t ownFnNum) {
   insertNode(&graph, callOp, ownFnNum);
 }
 
-void llvm_call_finished_instruction(char* callOp, unsigned ownFnNum) {
+void llvm_call_finished_instruction(char* callOp, uint64_t ownFnNum) {
   leaveNode(&graph, ownFnNum);
 }
 
-void llvm_build_and_write_dyncallgraph(int argc, const char **argv) {
-  save_dyn_arguments(argc, argv);
+int llvm_build_and_write_dyncallgraph(int argc, const char **argv) {
+  int Ret = save_dyn_arguments(argc, argv);
   atexit(CallGraphAtExitHandler);
+  return Ret;
 }
 
 void llvm_dummy_call(int i1, int i2, int i3) {
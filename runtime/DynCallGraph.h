@@ -15,6 +15,8 @@
 #ifndef DYNCALLGRAPH_H
 #define DYNCALLGRAPH_H
 
+#include <stdint.h>
+
 /* save_arguments - Save argc and argv as passed into the program for the file
  * we output.
  */
@@ -26,19 +28,21 @@ int save_dyn_arguments(int argc, const char **argv);
 void llvm_function_called(char* fnName, unsigned fnNum);
 
 /*
- * Inform the system about a call instruction.
+ * Inform the system about a call instruction. The number is the
+ * module-qualified ID of the call site.
  */
-void llvm_call_instruction(char* callOp, unsigned ownFnNum);
+void llvm_call_instruction(char* callOp, uint64_t ownFnNum);
 
 /*
  * Inform the system about the finishing of a function call.
  */
-void llvm_call_finished_instruction(char* callOp, unsigned ownFnNum);
+void llvm_call_finished_instruction(char* callOp, uint64_t ownFnNum);
 
 /*
- * Build a dynamic callgraph from the collected calling information.
+ * Build a dynamic callgraph from the collected calling information. Returns
+ * argc without the arguments meant for the runtime.
  */
-void llvm_build_and_write_dyncallgraph(int argc, const char **argv);
+int llvm_build_and_write_dyncallgraph(int argc, const char **argv);
 
 /*
  * A dummy call in order to measure the overhead for procedure calls.
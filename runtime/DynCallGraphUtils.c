@@ -14,18 +14,66 @@ double get_time() {
   return PAPI_get_real_cyc();
 }
 
+/*
+ * enterNode enters the child of the current node with the given call-site ID
+ * and name; the child is created if necessary. An indirect call site has one
+ * child per target.
+ */
+static void enterNode(fGraphT *g, char *name, uint64_t num, double start) {
+
+	/* declarations */
+	unsigned tmp, sibling;
+
+  /* check array size and increase dynamically */
+  if (g->nextSlot == g->currentSize) {
+    g->currentSize *= 2;
+    g->array = (fNodeT*)realloc(g->array, g->currentSize * sizeof(fNodeT));
+  }
+
+  /* check if node already exist */
+  tmp = g->array[g->currentNode].first_child;
+  while (tmp) {
+    if (g->array[tmp].num == num && strcmp(g->array[tmp].pName, name) == 0) {
+      g->array[tmp].count++;
+      g->array[tmp].exTime = start;
+      g->array[tmp].profiling = true;
+      g->currentNode = tmp;
+      return; /* prohibit more than one analysis per node */
+    }
+    tmp = g->array[tmp].sibling;
+  }
+
+  /* node doesn't exist => create new node (and link with parent/sibling) */
+  sibling = g->array[g->currentNode].last_child;
+  if (sibling)
+    g->array[sibling].sibling = g->nextSlot;
+  else
+    g->array[g->currentNode].first_child = g->nextSlot;
+  g->array[g->currentNode].last_child = g->nextSlot;
+
+  g->array[g->nextSlot].parent = g->currentNode;
+  g->currentNode = g->nextSlot++;
+  g->array[g->currentNode].pName = name;
+  g->array[g->currentNode].num = num;
+  g->array[g->currentNode].count = 1;
+  g->array[g->currentNode].exTime = start;
+  g->array[g->currentNode].ovTime = 0;
+  g->array[g->currentNode].tmpTime = 0;
+  g->array[g->currentNode].profiling = true;
+  g->array[g->currentNode].first_child = 0;
+  g->array[g->currentNode].last_child = 0;
+  g->array[g->currentNode].sibling = 0;
+}
+
 /*
  * insertNode inserts a new function node at the current (pCurrentLNode)
  * function.
  */
-void insertNode(fGraphT *g, char *name, unsigned num) {
+void insertNode(fGraphT *g, char *name, uint64_t num) {
 
 	/* get timestamp for overhead compensation */
 	double start = get_time();
 
-	/* declarations */
-	unsigned tmp, sibling;
-
   if (g->nextSlot == 0) {
   	if (strcmp(name, "main") != 0)
   		return;
@@ -34,6 +82,7 @@ void insertNode(fGraphT *g, char *name, unsigned num) {
   	g->nextSlot = STARTSLOT;
   	g->array = malloc(STARTSIZE * sizeof(fNodeT));
   	assert (g->array && "Error! Not enough memory");
+  	g->pending = false;
 
     /* create start node */
     g->currentNode = g->nextSlot++;
@@ -41,6 +90,7 @@ void insertNode(fGraphT *g, char *name, unsigned num) {
     g->array[g->currentNode].num = num;
     g->array[g->currentNode].count = 1;
     g->array[g->currentNode].exTime = get_time();
+    g->array[g->currentNode].ovTime = 0;
     g->array[g->currentNode].tmpTime = 0;
     g->array[g->currentNode].profiling = true;
     g->array[g->currentNode].parent = 0;
@@ -51,48 +101,14 @@ void insertNode(fGraphT *g, char *name, unsigned num) {
   } else {
   	assert(g->array[STARTSLOT].count && "Error! Inconsistent graph state");
 
-  	/* check array size and increase dynamically */
-  	if (g->nextSlot == g->currentSize) {
-  		g->currentSize *= 2;
-      g->array = (fNodeT*)realloc(g->array, g->currentSize * sizeof(fNodeT));
+  	/* an indirect call is entered when its target is known */
+  	if (strcmp(name, INDIRECT_CALL_NAME) == 0) {
+  	  g->pending = true;
+  	  g->pendingNum = num;
+  	  g->pendingTime = start;
+  	  return;
   	}
-
-    /* check if node already exist */
-    tmp = g->array[g->currentNode].first_child;
-    while (tmp) {
-      if (g->array[tmp].num == num) {
-      	g->array[tmp].count++;
-      	g->array[tmp].exTime = get_time();
-        g->array[tmp].profiling = true;
-        g->currentNode = tmp;
-
-			  /* increase overhead time for computation */
-  			g->array[tmp].ovTime += get_time() - start;
-
-        return; /* prohibit more than one analysis per node */
-      }
-      tmp = g->array[tmp].sibling;
-    }
-
-    /* node doesn't exist => create new node (and link with parent/sibling) */
-    sibling = g->array[g->currentNode].last_child;
-    if (sibling)
-    	g->array[sibling].sibling = g->nextSlot;
-    else
-			g->array[g->currentNode].first_child = g->nextSlot;
-		g->array[g->currentNode].last_child = g->nextSlot;
-
-    g->array[g->nextSlot].parent = g->currentNode;
-    g->currentNode = g->nextSlot++;
-    g->array[g->currentNode].pName = name;
-    g->array[g->currentNode].num = num;
-    g->array[g->currentNode].count = 1;
-    g->array[g->currentNode].exTime = get_time();
-    g->array[g->currentNode].tmpTime = 0;
-    g->array[g->currentNode].profiling = true;
-    g->array[g->currentNode].first_child = 0;
-    g->array[g->currentNode].last_child = 0;
-    g->array[g->currentNode].sibling = 0;
+  	enterNode(g, name, num, get_time());
   }
 
   /* increase overhead time for computation */
@@ -100,19 +116,19 @@ void insertNode(fGraphT *g, char *name, unsigned num) {
 }
 
 /*
- * changeCurrentFunctionName changes the name of the current node.
+ * changeCurrentFunctionName resolves the target of a pending indirect call
+ * when its callee is entered.
  */
 void changeCurrentFunctionName(fGraphT* g, char* name) {
 
-  if (g->nextSlot == 0)
+  if (g->nextSlot == 0 || !g->pending)
   	return;
 
 	/* get timestamp for overhead compensation */
 	double start = get_time();
 
-	assert (g->array[g->currentNode].count &&
-			"Error! No Function was called before!");
-  g->array[g->currentNode].pName = name;
+	g->pending = false;
+	enterNode(g, name, g->pendingNum, g->pendingTime);
 
   /* increase overhead time for computation */
   g->array[g->currentNode].ovTime += get_time() - start;
@@ -121,7 +137,7 @@ void changeCurrentFunctionName(fGraphT* g, char* name) {
 /*
  * leaveNode returns to the last function node.
  */
-void leaveNode(fGraphT* g, unsigned num) {
+void leaveNode(fGraphT* g, uint64_t num) {
   if (g->nextSlot == 0)
   	return;
 
@@ -129,7 +145,14 @@ void leaveNode(fGraphT* g, unsigned num) {
 	double start = get_time();
 
   /* declarations */
-	unsigned node = g->currentNode;
+	unsigned node;
+
+	/* the target of an indirect call wasn't instrumented */
+	if (g->pending) {
+	  g->pending = false;
+	  enterNode(g, INDIRECT_CALL_NAME, g->pendingNum, g->pendingTime);
+	}
+	node = g->currentNode;
 
 	assert(g->array[g->currentNode].count &&
   		"Error! Inconsistent call graph detected!");
@@ -190,8 +213,8 @@ void writeNode(FILE *outFile, fGraphT *g, unsigned nodeIndex,
   pNode->exTime = (pNode->exTime < 0) ? 0 : pNode->exTime;
 
   /* write node entry */
-  fprintf(outFile, "\tNode%u [shape=record,label=\"{%s;%u;%f}\"];\n",
-      nodeIndex, pNode->pName, pNode->num, pNode->exTime);
+  fprintf(outFile, "\tNode%u [shape=record,label=\"{%s;%llu;%f}\"];\n",
+      nodeIndex, pNode->pName, (unsigned long long)pNode->num, pNode->exTime);
 
   /* write link information */
   if (pNode->parent)
@@ -8,13 +8,14 @@
 #define STARTSLOT 1
 
 #include <stdbool.h>
+#include <stdint.h>
 
 /*
  *  a function node with its edges
  */
 typedef struct fNode {
 	char *pName;
-  unsigned num;
+  uint64_t num; /* call-site ID */
   unsigned count;
   double exTime;
   double ovTime; /* overhead time */
@@ -34,21 +35,32 @@ typedef struct fGraph {
 	unsigned currentSize;
 	unsigned currentNode;
 	unsigned nextSlot;
+  /* indirect call whose target isn't known until the callee is entered */
+  bool pending;
+  uint64_t pendingNum;
+  double pendingTime;
 } fGraphT;
 
+/* name of the call operand of indirect calls */
+#define INDIRECT_CALL_NAME "ext"
+
 
 
 /*
  * insertNode inserts a new function node at the current (pCurrentLNode)
  * function.
  */
-void insertNode(fGraphT *g, char *name, unsigned num);
+void insertNode(fGraphT *g, char *name, uint64_t num);
 
+/*
+ * changeCurrentFunctionName resolves the target of a pending indirect call
+ * when its callee is entered.
+ */
 void changeCurrentFunctionName(fGraphT* g, char* name);
 
 void writeGraphToFile(fGraphT *g, const char*);
 
-void leaveNode(fGraphT* g, unsigned num);
+void leaveNode(fGraphT* g, uint64_t num);
 
 void doNothing(int, int, int);
 
@@ -37,7 +37,7 @@ static unsigned NumElements;
  * data.
  */
 static void TimeProfAtExitHandler() {
-  write_profiling_data_d(ArrayStart, NumElements);
+  write_profiling_data_d(FunctionTInfo, ArrayStart, NumElements);
 }
 
 
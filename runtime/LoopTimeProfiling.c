@@ -0,0 +1,160 @@
+/*===-- LoopTimeProfiling.c - Support library for loop time profiling -----===*\
+|*
+|*                 ParPot - Parallelization Potential - Measurement
+|*
+|*===----------------------------------------------------------------------===*|
+|*
+|* This file implements the call back routines for the loop time profiling
+|* instrumentation pass.  This should be used with the -insert-ltime-profiling
+|* LLVM pass.
+|*
+\*===----------------------------------------------------------------------===*/
+
+#include "Profiling.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <papi.h>
+
+/* LoopState - Runtime state of a single loop. Only the outermost activation of
+ * a loop is timed; activations of recursive calls are part of its iterations.
+ */
+typedef struct {
+  unsigned depth;       /* number of active activations */
+  int inIteration;      /* 1 if an iteration is running */
+  double enterTime;     /* start of the current activation */
+  double iterStart;     /* start of the current iteration */
+} LoopState;
+
+static double *ArrayStart;
+static unsigned NumElements;
+static LoopState *States;
+
+/* The stack of active loop activations, innermost last. It lets landing pads
+ * close the loops that an exception left.
+ */
+static unsigned *ActiveLoops;
+static unsigned NumActive, MaxActive;
+
+/* close_iteration - Adds the time of a finished iteration to the record of a
+ * loop (streaming mean and variance).
+ */
+static void close_iteration(double *rec, double time) {
+  double n = ++rec[LoopTrips];
+  double delta = time - rec[LoopIterMean];
+  if (n == 1 || time < rec[LoopIterMin])
+    rec[LoopIterMin] = time;
+  if (n == 1 || time > rec[LoopIterMax])
+    rec[LoopIterMax] = time;
+  rec[LoopIterMean] += delta / n;
+  rec[LoopIterM2] += delta * (time - rec[LoopIterMean]);
+}
+
+/* close_loop - Finishes the outermost activation of a loop. */
+static void close_loop(unsigned id, double now) {
+  LoopState *s = &States[id];
+  double *rec = ArrayStart + id * LoopRecordSize;
+  if (s->inIteration)
+    close_iteration(rec, now - s->iterStart);
+  s->inIteration = 0;
+  rec[LoopTotal] += now - s->enterTime;
+  rec[LoopInvocations] += 1;
+}
+
+/* leave_loop - Ends an activation of a loop. */
+static void leave_loop(unsigned id) {
+  LoopState *s = &States[id];
+  if (!s->depth || --s->depth)
+    return;
+  close_loop(id, PAPI_get_real_cyc());
+}
+
+/* LoopProfAtExitHandler - When the program exits, close the loops that are
+ * still active (e.g. exit() within a loop) and write out the profiling data.
+ */
+static void LoopProfAtExitHandler() {
+  unsigned i, numLoops = NumElements / LoopRecordSize;
+  double now = PAPI_get_real_cyc();
+  for (i = 0; i != numLoops; ++i)
+    if (States[i].depth) {
+      States[i].depth = 0;
+      close_loop(i, now);
+    }
+  NumActive = 0;
+  write_profiling_data_d(LoopTInfo, ArrayStart, NumElements);
+}
+
+/* llvm_start_ltime_profiling - This is the main entry point of the loop time
+ * profiling library.  It is responsible for setting up the atexit handler.
+ */
+int llvm_start_ltime_profiling(int argc, const char **argv,
+                               double *arrayStart, unsigned numElements) {
+  int Ret = save_arguments(argc, argv);
+  ArrayStart = arrayStart;
+  NumElements = numElements;
+  States = (LoopState*)calloc(numElements / LoopRecordSize + 1,
+                              sizeof(LoopState));
+  atexit(LoopProfAtExitHandler);
+  return Ret;
+}
+
+/* llvm_loop_enter - Called on every edge that enters the loop. */
+void llvm_loop_enter(unsigned id) {
+  LoopState *s = &States[id];
+  if (NumActive == MaxActive) {
+    MaxActive = MaxActive ? 2 * MaxActive : 64;
+    ActiveLoops = (unsigned*)realloc(ActiveLoops,
+                                     MaxActive * sizeof(unsigned));
+    if (!ActiveLoops) {
+      fprintf(stderr, "LLVM profiling runtime: out of memory for %u active "
+              "loops\n", MaxActive);
+      abort();
+    }
+  }
+  ActiveLoops[NumActive++] = id;
+
+  if (s->depth++)
+    return; /* recursive activation */
+  s->inIteration = 0;
+  s->enterTime = PAPI_get_real_cyc();
+}
+
+/* llvm_loop_iteration - Called at the loop header, i.e. at the beginning of
+ * every iteration.
+ */
+void llvm_loop_iteration(unsigned id) {
+  LoopState *s = &States[id];
+  double now;
+  if (s->depth != 1)
+    return;
+
+  now = PAPI_get_real_cyc();
+  if (s->inIteration)
+    close_iteration(ArrayStart + id * LoopRecordSize, now - s->iterStart);
+  s->inIteration = 1;
+  s->iterStart = now;
+}
+
+/* llvm_loop_exit - Called on every edge that leaves the loop and before
+ * returns within the loop.
+ */
+void llvm_loop_exit(unsigned id) {
+  if (NumActive && ActiveLoops[NumActive - 1] == id)
+    --NumActive;
+  leave_loop(id);
+}
+
+/* llvm_loop_depth - Called on entry of functions with landing pads. Returns
+ * the number of active loop activations.
+ */
+unsigned llvm_loop_depth(void) {
+  return NumActive;
+}
+
+/* llvm_loop_unwind - Called at landing pads. Leaves the innermost loop
+ * activations until depth of them remain, i.e. the loops that an exception
+ * left without passing their exits.
+ */
+void llvm_loop_unwind(unsigned depth) {
+  while (NumActive > depth)
+    leave_loop(ActiveLoops[--NumActive]);
+}
@@ -15,13 +15,17 @@
 #ifndef PARPOT_PROFILING_H
 #define PARPOT_PROFILING_H
 
-#include "llvm/Analysis/ProfileInfoTypes.h" /* for enum ProfilingType */
+#include "Analysis/TimeProfileInfoTypes.h" /* for enum TimeProfilingType */
 
 /* save_arguments - Save argc and argv as passed into the program for the file
  * we output.
  */
 int save_arguments(int argc, const char **argv);
 
-void write_profiling_data_d(double *Start, unsigned NumElements);
+/* write_profiling_data_d - Write a packet of the given type with a raw block of
+ * timers to the output file.
+ */
+void write_profiling_data_d(enum TimeProfilingType PT, double *Start,
+                            unsigned NumElements);
 
 #endif
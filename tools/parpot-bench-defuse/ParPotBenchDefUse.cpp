@@ -0,0 +1,305 @@
+//===------- ParPotBenchDefUse.cpp - Def-use analysis benchmark -----------===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// The parpot-bench-defuse tool builds a synthetic function with a given number
+// of call sites and runs the correlation analysis on all pairs of them, once
+// with the recursive def-use walk per query the analysis used before and once
+// with the DefUseIndex. It reports the time and the dependences found of both;
+// the index may find more, as the old walk stopped at the first nested branch.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Analysis/AnalysisContext.h"
+#include "Analysis/CorrelationAnalysis.h"
+#include "Analysis/DepGraph.h"
+#include "DynCallGraph/DynCallGraph.h"
+
+#include "llvm/Constants.h"
+#include "llvm/DerivedTypes.h"
+#include "llvm/GlobalVariable.h"
+#include "llvm/LLVMContext.h"
+#include "llvm/Module.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/IRBuilder.h"
+#include "llvm/Support/InstIterator.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <set>
+#include <vector>
+using namespace llvm;
+
+namespace {
+  cl::opt<unsigned>
+  NumSites("sites", cl::desc("Number of call sites (default = 600)"),
+           cl::init(600));
+
+  cl::opt<unsigned>
+  NumSlots("slots", cl::desc("Number of local variables passed to the calls "
+                             "(default = 8)"),
+           cl::init(8));
+
+  /// The correlation analysis as it was before the DefUseIndex: every query
+  /// walks the uses of the value recursively.
+  class LegacyCorrelationAnalysis : public Analysis {
+    std::set<Value*> visitedVals_;
+    std::set<BranchInst*> visitedBranches_;
+
+    bool checkDefUse(Value*, Instruction*, int level, bool phiVisited);
+    bool checkBranchDefUse(BranchInst*, Instruction*, int level,
+                           int branchLevel);
+
+  public:
+    LegacyCorrelationAnalysis(AnalysisContext *ctx, AnalysisCache *cache)
+      : Analysis(ctx, cache) { }
+
+    void analyze(Function*, Instruction*, Instruction*);
+  };
+}
+
+bool LegacyCorrelationAnalysis::checkDefUse(Value *val, Instruction *iB,
+                                            int level, bool phiVisited) {
+  if (!level)
+    visitedVals_.clear();
+
+  // ignore already visited values
+  if (!visitedVals_.insert(val).second)
+    return false;
+
+  // check if function A is correlated with function B
+  if ((isa<CallInst>(val) || isa<InvokeInst>(val)) && val == iB)
+    return phiVisited;
+
+  // consider store instructions
+  if (StoreInst *sInst = dyn_cast<StoreInst>(val))
+    if (checkDefUse(sInst->getPointerOperand(), iB, level + 1, phiVisited))
+      return phiVisited;
+
+  // consider branch instructions
+  if (BranchInst *bInst = dyn_cast<BranchInst>(val))
+    if (checkBranchDefUse(bInst, iB, level + 1, 0))
+      return true;
+
+  // consider llvm.memcpy instructions
+  if (MemCpyInst *mcpInst = dyn_cast<MemCpyInst>(val)) {
+    Value *v = mcpInst->getArgOperand(0);
+    if (checkDefUse(v, iB, level + 1, phiVisited))
+      return true;
+    if (Operator::getOpcode(v) == Instruction::BitCast &&
+        checkDefUse(cast<Operator>(v)->getOperand(0), iB, level + 1,
+                    phiVisited))
+      return true;
+  }
+
+  // check every use of the value recursively
+  for (Value::use_iterator iUse = val->use_begin(), eUse = val->use_end();
+       iUse != eUse; ++iUse)
+    if (checkDefUse(*iUse, iB, level + 1, phiVisited))
+      return true;
+
+  return false;
+}
+
+bool LegacyCorrelationAnalysis::checkBranchDefUse(BranchInst *bInst,
+                                                  Instruction *iB, int level,
+                                                  int branchLevel) {
+  if (!branchLevel)
+    visitedBranches_.clear();
+
+  // ignore already visited branches
+  if (!visitedBranches_.insert(bInst).second)
+    return false;
+
+  for (unsigned i = 0; i < bInst->getNumSuccessors(); ++i) {
+    BasicBlock *bb = bInst->getSuccessor(i);
+    for (BasicBlock::iterator it = bb->begin(), e = bb->end(); it != e; ++it) {
+      // consider store instructions and PHINodes within branches
+      if (isa<StoreInst>(&*it) || isa<PHINode>(&*it))
+        if (checkDefUse(&*it, iB, level + 1, true))
+          return true;
+
+      // check if branch is correlated with function B
+      if (&*it == iB)
+        return true;
+
+      // consider new branch instructions within branches
+      if (BranchInst *next = dyn_cast<BranchInst>(&*it))
+        return checkBranchDefUse(next, iB, level + 1, branchLevel + 1);
+    }
+  }
+  return false;
+}
+
+// analyze - The same queries as CorrelationAnalysis::analyze().
+void LegacyCorrelationAnalysis::analyze(Function *parent, Instruction *iA,
+                                        Instruction *iB) {
+  DepGraph *graph = (*ctx_->getDepGraphs())[parent];
+  AnalysisContext::CalleeVecTy callees;
+  if (!ctx_->getCallees(CallSite(iA), callees))
+    return;
+
+  for (AnalysisContext::CalleeVecTy::iterator iCallee = callees.begin(),
+        eCallee = callees.end(); iCallee != eCallee; ++iCallee) {
+    Function *fA = iCallee->first;
+    for (Function::arg_iterator it = fA->arg_begin(), e = fA->arg_end();
+         it != e; ++it)
+      if (it->getType()->isPointerTy() && (getModRefForArg(fA, &*it) & Mod)) {
+        Value *arg = iA->getOperand(it->getArgNo());
+        if (checkDefUse(arg, iB, 0, false))
+          graph->addDependence(iA, iB, ControlDependence, arg->getName(), "-");
+      }
+
+    const ModRefSummary &summary = ctx_->getModRefSummary();
+    const BitVector &writesA = summary.getWrites(fA);
+    for (int i = writesA.find_first(); i != -1; i = writesA.find_next(i)) {
+      GlobalVariable *gv = summary.getGlobal(i);
+      if (checkDefUse(gv, iB, 0, false))
+        graph->addDependence(iA, iB, ControlDependence, gv->getName(), "-");
+    }
+  }
+
+  if (checkDefUse(iA, iB, 0, true))
+    graph->addDependence(iA, iB, CorrelationDependece, NoObj, NoObj);
+}
+
+// buildModule - Creates the function "bench" with about the given number of
+// call sites. Each step writes a local variable through a pointer, computes a
+// value from another one and branches on it to a block that stores the value
+// and passes it on, so the walks follow stores, loads, branches and calls.
+static Function *buildModule(Module &M, unsigned sites, unsigned slots) {
+  LLVMContext &context = M.getContext();
+  Type *voidTy = Type::getVoidTy(context);
+  IntegerType *int32Ty = Type::getInt32Ty(context);
+  Type *int32PtrTy = PointerType::getUnqual(int32Ty);
+  GlobalVariable *global =
+    new GlobalVariable(M, int32Ty, false, GlobalValue::InternalLinkage,
+                       ConstantInt::get(int32Ty, 0), "state");
+
+  // void produce(i32 *p): *p = 1; state = 1
+  Function *produce =
+    Function::Create(FunctionType::get(voidTy, int32PtrTy, false),
+                     GlobalValue::InternalLinkage, "produce", &M);
+  IRBuilder<> builder(BasicBlock::Create(context, "entry", produce));
+  builder.CreateStore(ConstantInt::get(int32Ty, 1), produce->arg_begin());
+  builder.CreateStore(ConstantInt::get(int32Ty, 1), global);
+  builder.CreateRetVoid();
+
+  // i32 compute(i32 x): return x + 1
+  Function *compute =
+    Function::Create(FunctionType::get(int32Ty, int32Ty, false),
+                     GlobalValue::InternalLinkage, "compute", &M);
+  builder.SetInsertPoint(BasicBlock::Create(context, "entry", compute));
+  builder.CreateRet(builder.CreateAdd(compute->arg_begin(),
+                                      ConstantInt::get(int32Ty, 1)));
+
+  // void consume(i32 x): reads state
+  Function *consume =
+    Function::Create(FunctionType::get(voidTy, int32Ty, false),
+                     GlobalValue::InternalLinkage, "consume", &M);
+  builder.SetInsertPoint(BasicBlock::Create(context, "entry", consume));
+  builder.CreateLoad(global);
+  builder.CreateRetVoid();
+
+  Function *bench =
+    Function::Create(FunctionType::get(voidTy, int32Ty, false),
+                     GlobalValue::ExternalLinkage, "bench", &M);
+  builder.SetInsertPoint(BasicBlock::Create(context, "entry", bench));
+  std::vector<Value*> slot;
+  for (unsigned i = 0; i < slots; ++i)
+    slot.push_back(builder.CreateAlloca(int32Ty));
+
+  for (unsigned i = 0; 3 * i < sites; ++i) {
+    builder.CreateCall(produce, slot[i % slots]);
+    Value *v = builder.CreateLoad(slot[(i + 3) % slots]);
+    Value *r = builder.CreateCall(compute, v);
+    Value *c = builder.CreateICmpSGT(r, bench->arg_begin());
+
+    BasicBlock *then = BasicBlock::Create(context, "then", bench);
+    BasicBlock *cont = BasicBlock::Create(context, "cont", bench);
+    builder.CreateCondBr(c, then, cont);
+    builder.SetInsertPoint(then);
+    builder.CreateStore(r, slot[(i + 1) % slots]);
+    builder.CreateCall(consume, r);
+    builder.CreateBr(cont);
+    builder.SetInsertPoint(cont);
+  }
+  builder.CreateRetVoid();
+  return bench;
+}
+
+// countDependences - Returns the number of dependences of the graph.
+static unsigned countDependences(DepGraph &graph) {
+  graph.finalize();
+  unsigned n = 0;
+  for (DepGraph::iterator it = graph.begin(), e = graph.end(); it != e; ++it)
+    n += (*it)->outDepEnd() - (*it)->outDepBegin();
+  return n;
+}
+
+// runPairs - Analyzes all pairs of call sites like ParPot does and returns the
+// wall time.
+static double runPairs(Analysis &analysis, Function *F,
+                       const std::vector<Instruction*> &calls) {
+  TimeRecord start = TimeRecord::getCurrentTime(true);
+  for (unsigned i = 0, e = calls.size(); i != e; ++i)
+    for (unsigned j = i + 1; j < e; ++j)
+      analysis.analyze(F, calls[i], calls[j]);
+  TimeRecord time = TimeRecord::getCurrentTime(false);
+  time -= start;
+  return time.getWallTime();
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
+
+  cl::ParseCommandLineOptions(argc, argv, "parpot def-use benchmark\n");
+
+  LLVMContext &context = getGlobalContext();
+  Module M("parpot-bench-defuse", context);
+  Function *F = buildModule(M, NumSites, NumSlots ? NumSlots : 1);
+
+  std::vector<Instruction*> calls;
+  for (inst_iterator it = inst_begin(F), e = inst_end(F); it != e; ++it)
+    if (isa<CallInst>(&*it))
+      calls.push_back(&*it);
+
+  // direct calls only, so neither a static call graph nor DSA is needed
+  DynCallGraph dcg;
+  AnalysisContext ctx(&M, &dcg, 0, 0, 0);
+  ctx.computeModRefSummary();
+  DepGraph *&graph = (*ctx.getDepGraphs())[F];
+  AnalysisCache cache;
+
+  graph = new DepGraph(F);
+  LegacyCorrelationAnalysis legacy(&ctx, &cache);
+  double legacyTime = runPairs(legacy, F, calls);
+  unsigned legacyDeps = countDependences(*graph);
+  delete graph;
+
+  graph = new DepGraph(F);
+  CorrelationAnalysis indexed(&ctx, &cache);
+  double indexedTime = runPairs(indexed, F, calls);
+  unsigned indexedDeps = countDependences(*graph);
+  delete graph;
+  graph = 0;
+
+  outs() << "call sites: " << calls.size() << ", pairs: "
+         << calls.size() * (calls.size() - 1) / 2 << '\n'
+         << "recursive walk: " << format("%.3f", legacyTime) << "s, "
+         << legacyDeps << " dependences\n"
+         << "def-use index:  " << format("%.3f", indexedTime) << "s, "
+         << indexedDeps << " dependences\n";
+  if (indexedTime > 0.0)
+    outs() << "speedup: " << format("%.1f", legacyTime / indexedTime) << "x\n";
+  return 0;
+}
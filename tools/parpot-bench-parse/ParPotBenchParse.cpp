@@ -0,0 +1,179 @@
+//===------- ParPotBenchParse.cpp - Graph reader benchmark ----------------===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// The parpot-bench-parse tool writes a synthetic dynamic call graph of a given
+// number of nodes in the format of the runtime and measures how fast
+// readDynCallGraph() reads it. It fails if nodes or calls get lost.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DynCallGraph/DynCallGraph.h"
+#include "DynCallGraph/DynCallGraphParser.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <vector>
+using namespace llvm;
+
+namespace {
+  cl::opt<unsigned>
+  NumNodes("nodes",
+           cl::desc("Number of nodes of the graph (default = 1000000)"),
+           cl::init(1000000));
+
+  cl::opt<unsigned>
+  NumFunctions("functions",
+               cl::desc("Number of distinct functions (default = 1000)"),
+               cl::init(1000));
+
+  cl::opt<unsigned>
+  NumRepeats("repeat", cl::desc("Number of timed reads (default = 3)"),
+             cl::init(3));
+
+  cl::opt<bool>
+  CreationIDs("creation-ids",
+              cl::desc("Number the nodes breadth-first like the runtime "
+                       "creates them, so the IDs within the file aren't "
+                       "increasing (default = true)"),
+              cl::init(true));
+
+  cl::opt<double>
+  MinFraction("min-fraction",
+              cl::desc("Skip subtrees below this fraction of the total time "
+                       "while reading (default = 0)"),
+              cl::init(0.0));
+
+  cl::opt<std::string>
+  OutputFile("o", cl::desc("Graph file to write and read "
+                           "(default = 'bench-dyncallgraph.dot')"),
+             cl::value_desc("filename"), cl::init("bench-dyncallgraph.dot"));
+}
+
+// writeGraph - Writes a tree of n nodes in preorder like the runtime does and
+// returns the number of calls. The parent of each node is a pseudo-random node
+// on the path to the previous one, so the depth varies; the time of a node
+// halves with every level. With creationIDs, the nodes are numbered level by
+// level, so a deep node early in the file gets a large ID.
+static bool writeGraph(const std::string &filename, unsigned n,
+                       unsigned functions, bool creationIDs,
+                       uint64_t &calls) {
+  std::string errorInfo;
+  raw_fd_ostream out(filename.c_str(), errorInfo);
+  if (!errorInfo.empty()) {
+    errs() << "Error: Can't open file " << filename << ": " << errorInfo
+           << '\n';
+    return false;
+  }
+
+  // the tree in preorder
+  std::vector<unsigned> parent(n, 0), depth(n, 0);
+  std::vector<unsigned> path(1, 0);
+  uint32_t seed = 1;
+  for (unsigned i = 1; i < n; ++i) {
+    seed = seed * 1103515245U + 12345U;
+    path.resize(1 + (seed >> 16) % path.size());
+    parent[i] = path.back();
+    depth[i] = path.size();
+    path.push_back(i);
+  }
+
+  // breadth-first numbers are ordered by depth, then by preorder
+  std::vector<unsigned> ids(n);
+  if (creationIDs) {
+    std::vector<unsigned> first;
+    for (unsigned i = 0; i < n; ++i) {
+      if (depth[i] >= first.size())
+        first.resize(depth[i] + 1, 0);
+      ++first[depth[i]];
+    }
+    unsigned next = 1;
+    for (unsigned d = 0, e = first.size(); d != e; ++d) {
+      unsigned count = first[d];
+      first[d] = next;
+      next += count;
+    }
+    for (unsigned i = 0; i < n; ++i)
+      ids[i] = first[depth[i]]++;
+  } else
+    for (unsigned i = 0; i < n; ++i)
+      ids[i] = i + 1;
+
+  out << "digraph \"Dynamic Call Graph\" {\n";
+  out << "\tlabel=\"Dynamic Call Graph\";\n\n";
+  out << "\tNode" << ids[0] << " [shape=record,label=\"{main;0;"
+      << format("%f", 1e12) << "}\"];\n";
+
+  calls = 0;
+  for (unsigned i = 1; i < n; ++i) {
+    double exTime = 1e12 / (1ULL << std::min<unsigned>(depth[i], 40));
+    unsigned fn = i % (functions ? functions : 1);
+    unsigned count = 1 + i % 7;
+    out << "\tNode" << ids[i] << " [shape=record,label=\"{fn" << fn << ';'
+        << (uint64_t)i << ';' << format("%f", exTime) << "}\"];\n";
+    out << "\tNode" << ids[parent[i]] << " -> Node" << ids[i]
+        << " [label=\"" << count << "\"];\n";
+    calls += count;
+  }
+  out << "}";
+  return true;
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
+
+  cl::ParseCommandLineOptions(argc, argv, "parpot graph reader benchmark\n");
+
+  if (!NumNodes) {
+    errs() << argv[0] << ": the graph needs at least one node\n";
+    return 1;
+  }
+  uint64_t calls;
+  if (!writeGraph(OutputFile, NumNodes, NumFunctions, CreationIDs, calls))
+    return 1;
+
+  // the fastest of the reads is reported
+  double best = 0.0;
+  size_t memory = 0;
+  unsigned nodes = 0;
+  uint64_t callsRead = 0;
+  for (unsigned i = 0; i < NumRepeats; ++i) {
+    DynCallGraph graph;
+    TimeRecord start = TimeRecord::getCurrentTime(true);
+    if (!readDynCallGraph(OutputFile, graph, MinFraction))
+      return 1;
+    TimeRecord time = TimeRecord::getCurrentTime(false);
+    time -= start;
+
+    if (!i || time.getWallTime() < best)
+      best = time.getWallTime();
+    memory = graph.getMemoryUsage();
+    nodes = graph.size();
+    callsRead = graph.getTotNoCalls();
+  }
+
+  outs() << "nodes written: " << NumNodes << ", read: " << nodes << '\n'
+         << "best of " << NumRepeats << ": " << format("%.3f", best) << "s, "
+         << format("%.0f", best > 0.0 ? NumNodes / best : 0.0)
+         << " nodes/s, " << memory / 1024 << " KiB\n";
+
+  // without skipping, every node and call has to be read
+  if (NumRepeats && MinFraction <= 0.0 &&
+      (nodes != NumNodes || callsRead != calls)) {
+    errs() << argv[0] << ": read " << nodes << " nodes and " << callsRead
+           << " calls instead of " << NumNodes << " and " << calls << '\n';
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,327 @@
+//===------------ ParPotDiff.cpp - Profile comparison tool ----------------===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// The parpot-diff tool compares two dynamic call graphs and, optionally, two
+// time profiles. Calling contexts are aligned by call-site ID and function
+// name below aligned parents, so the comparison is linear in the size of the
+// graphs. Changed, new and vanished contexts are reported by their absolute
+// impact on the execution time.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DynCallGraph/DynCallGraph.h"
+#include "DynCallGraph/DynCallGraphParser.h"
+#include "Analysis/TimeProfileInfoLoader.h"
+
+#include "llvm/LLVMContext.h"
+#include "llvm/Module.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+using namespace llvm;
+
+namespace {
+  cl::opt<std::string>
+  OldGraph(cl::Positional, cl::desc("<old dynamic call graph>"), cl::Required);
+
+  cl::opt<std::string>
+  NewGraph(cl::Positional, cl::desc("<new dynamic call graph>"), cl::Required);
+
+  cl::opt<std::string>
+  OldTimeProfile("time-old",
+                 cl::desc("Time profile of the old version"),
+                 cl::value_desc("filename"));
+
+  cl::opt<std::string>
+  NewTimeProfile("time-new",
+                 cl::desc("Time profile of the new version"),
+                 cl::value_desc("filename"));
+
+  cl::opt<std::string>
+  ModuleFile("module",
+             cl::desc("Bitcode that names the functions of the time profiles"),
+             cl::value_desc("bitcode"));
+
+  cl::opt<unsigned>
+  TopN("top", cl::desc("Number of entries reported (default = 30, 0 = all)"),
+       cl::init(30));
+
+  /// A calling context of both profiles (Changed) or of one of them.
+  struct ContextDiff {
+    enum Kind { Changed, New, Vanished };
+
+    Kind kind;
+    DynCallGraphNode *oldNode, *newNode;
+    unsigned oldCount, newCount;
+    int parent; // index of the aligned parent context or -1
+
+    ContextDiff(Kind k, DynCallGraphNode *o, DynCallGraphNode *n,
+                unsigned oc, unsigned nc, int p)
+      : kind(k), oldNode(o), newNode(n), oldCount(oc), newCount(nc),
+        parent(p) { }
+
+    double getOldTime() const { return oldNode ? oldNode->getExTime() : 0.0; }
+    double getNewTime() const { return newNode ? newNode->getExTime() : 0.0; }
+    double getImpact() const { return std::fabs(getNewTime() - getOldTime()); }
+  };
+
+  /// A call of the old graph that may be aligned with a call of the new one.
+  struct CallSlot {
+    DynCallGraphNode *node;
+    unsigned count;
+    int next;     // next call of the same parent and call site or -1
+    bool matched;
+
+    CallSlot(DynCallGraphNode *n, unsigned c)
+      : node(n), count(c), next(-1), matched(false) { }
+  };
+
+  typedef DenseMap<std::pair<unsigned, uint64_t>, int> CallIndexTy;
+
+  /// Orders entries by descending impact.
+  template<class T>
+  struct ImpactComp {
+    bool operator()(const T *p, const T *q) const {
+      return q->getImpact() < p->getImpact();
+    }
+  };
+}
+
+// compareGraphs - Aligns the contexts of both graphs. The calls of the old
+// graph are indexed by their parent and call site once; the new graph is then
+// walked from the root, looking up every call in the index.
+static void compareGraphs(DynCallGraph &oldDCG, DynCallGraph &newDCG,
+                          std::vector<ContextDiff> &diffs) {
+  std::vector<CallSlot> slots;
+  CallIndexTy index;
+  DenseMap<DynCallGraphNode*, unsigned> firstSlot;
+  for (DynCallGraph::iterator it = oldDCG.begin(), e = oldDCG.end();
+       it != e; ++it) {
+    firstSlot[*it] = slots.size();
+    for (DynCallGraphNode::iterator ci = (*it)->begin(), ce = (*it)->end();
+         ci != ce; ++ci) {
+      CallSlot slot(ci->first, ci->second);
+      std::pair<CallIndexTy::iterator, bool> entry = index.insert(
+        std::make_pair(std::make_pair((*it)->getID(), ci->first->getNum()),
+                       (int)slots.size()));
+      if (!entry.second) {
+        slot.next = entry.first->second;
+        entry.first->second = slots.size();
+      }
+      slots.push_back(slot);
+    }
+  }
+
+  if (!oldDCG.getRoot() || !newDCG.getRoot())
+    return;
+  diffs.push_back(ContextDiff(ContextDiff::Changed, oldDCG.getRoot(),
+                              newDCG.getRoot(), 1, 1, -1));
+  std::vector<int> worklist(1, 0);
+  while (!worklist.empty()) {
+    int idx = worklist.back();
+    worklist.pop_back();
+    DynCallGraphNode *oldNode = diffs[idx].oldNode;
+    DynCallGraphNode *newNode = diffs[idx].newNode;
+
+    // align the calls of the new context
+    for (DynCallGraphNode::iterator ci = newNode->begin(), ce = newNode->end();
+         ci != ce; ++ci) {
+      CallIndexTy::iterator entry =
+        index.find(std::make_pair(oldNode->getID(), ci->first->getNum()));
+      int s = entry != index.end() ? entry->second : -1;
+      for (; s != -1; s = slots[s].next)
+        if (!slots[s].matched &&
+            slots[s].node->getNameRef() == ci->first->getNameRef())
+          break;
+
+      if (s == -1) {
+        diffs.push_back(ContextDiff(ContextDiff::New, 0, ci->first, 0,
+                                    ci->second, idx));
+        continue;
+      }
+      slots[s].matched = true;
+      worklist.push_back(diffs.size());
+      diffs.push_back(ContextDiff(ContextDiff::Changed, slots[s].node,
+                                  ci->first, slots[s].count, ci->second, idx));
+    }
+
+    // the remaining calls of the old context vanished
+    unsigned first = firstSlot[oldNode];
+    for (unsigned s = first, se = first + oldNode->size(); s != se; ++s)
+      if (!slots[s].matched)
+        diffs.push_back(ContextDiff(ContextDiff::Vanished, slots[s].node, 0,
+                                    slots[s].count, 0, idx));
+  }
+}
+
+// printContext - Prints the calling context of a diff entry.
+static void printContext(raw_ostream &out,
+                         const std::vector<ContextDiff> &diffs,
+                         const ContextDiff &diff) {
+  std::vector<StringRef> path;
+  for (const ContextDiff *d = &diff; ; d = &diffs[d->parent]) {
+    path.push_back(d->newNode ? d->newNode->getNameRef()
+                              : d->oldNode->getNameRef());
+    if (d->parent < 0) break;
+  }
+  for (std::vector<StringRef>::reverse_iterator it = path.rbegin(),
+        e = path.rend(); it != e; ++it)
+    out << (it == path.rbegin() ? "" : " > ") << *it;
+}
+
+static void reportGraphs(raw_ostream &out, const DynCallGraph &oldDCG,
+                         const DynCallGraph &newDCG,
+                         const std::vector<ContextDiff> &diffs) {
+  unsigned changed = 0, added = 0, vanished = 0;
+  std::vector<const ContextDiff*> sorted;
+  for (std::vector<ContextDiff>::const_iterator it = diffs.begin(),
+        e = diffs.end(); it != e; ++it) {
+    if (it->kind == ContextDiff::New) ++added;
+    else if (it->kind == ContextDiff::Vanished) ++vanished;
+    else if (it->getImpact() > 0.0 || it->oldCount != it->newCount) ++changed;
+    else continue;
+    sorted.push_back(&*it);
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   ImpactComp<ContextDiff>());
+
+  out << "Dynamic call graph: " << OldGraph << " -> " << NewGraph << '\n'
+      << "  total time: " << format("%.6f", oldDCG.getTotExecutionTime())
+      << " -> " << format("%.6f", newDCG.getTotExecutionTime()) << '\n'
+      << "  contexts: " << changed << " changed, " << added << " new, "
+      << vanished << " vanished\n\n";
+
+  out << "      old time      new time         delta    calls  context\n";
+  unsigned n = TopN ? std::min<unsigned>(TopN, sorted.size()) : sorted.size();
+  for (unsigned i = 0; i != n; ++i) {
+    const ContextDiff &d = *sorted[i];
+    out << format("%14.6f%14.6f%+14.6f", d.getOldTime(), d.getNewTime(),
+                  d.getNewTime() - d.getOldTime());
+    out << format("%+9d", (int)d.newCount - (int)d.oldCount) << "  ";
+    if (d.kind == ContextDiff::New) out << "[new] ";
+    if (d.kind == ContextDiff::Vanished) out << "[vanished] ";
+    printContext(out, diffs, d);
+    out << '\n';
+  }
+}
+
+namespace {
+  /// The time of a function in both time profiles.
+  struct FunctionDiff {
+    std::string name;
+    double oldTime, newTime;
+
+    FunctionDiff(const std::string &n, double o, double t)
+      : name(n), oldTime(o), newTime(t) { }
+
+    double getImpact() const { return std::fabs(newTime - oldTime); }
+  };
+}
+
+// getTime - Returns the time of function i or 0 if it wasn't profiled.
+static double getTime(const std::vector<double> &times, unsigned i) {
+  if (i >= times.size() || times[i] == TimeProfileInfoLoader::Uncounted)
+    return 0.0;
+  return times[i];
+}
+
+static void reportTimeProfiles(raw_ostream &out, const char *toolName,
+                               Module &M) {
+  TimeProfileInfoLoader oldPIL(toolName, OldTimeProfile, M);
+  TimeProfileInfoLoader newPIL(toolName, NewTimeProfile, M);
+  const std::vector<double> &oldTimes = oldPIL.getRawFunctionTimes();
+  const std::vector<double> &newTimes = newPIL.getRawFunctionTimes();
+
+  // functions are numbered like the defined functions of the module
+  std::vector<FunctionDiff> diffs;
+  Module::iterator F = M.begin(), FE = M.end();
+  for (unsigned i = 0, e = std::max(oldTimes.size(), newTimes.size());
+       i != e; ++i) {
+    while (F != FE && F->isDeclaration()) ++F;
+    std::string name;
+    if (F != FE)
+      name = (F++)->getName().str();
+    else
+      name = "function #" + utostr(i);
+    diffs.push_back(FunctionDiff(name, getTime(oldTimes, i),
+                                 getTime(newTimes, i)));
+  }
+
+  std::vector<const FunctionDiff*> sorted;
+  for (unsigned i = 0, e = diffs.size(); i != e; ++i)
+    sorted.push_back(&diffs[i]);
+  std::stable_sort(sorted.begin(), sorted.end(), ImpactComp<FunctionDiff>());
+
+  out << "\nTime profile: " << OldTimeProfile << " -> " << NewTimeProfile
+      << "\n      old time      new time         delta  function\n";
+  unsigned n = TopN ? std::min<unsigned>(TopN, sorted.size()) : sorted.size();
+  for (unsigned i = 0; i != n; ++i)
+    out << format("%14.6f%14.6f%+14.6f", sorted[i]->oldTime,
+                  sorted[i]->newTime, sorted[i]->newTime - sorted[i]->oldTime)
+        << "  " << sorted[i]->name << '\n';
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
+
+  cl::ParseCommandLineOptions(argc, argv, "parpot profile comparison\n");
+
+  // both graphs are held side by side
+  DynCallGraph oldDCG, newDCG;
+  if (!readDynCallGraph(OldGraph, oldDCG) ||
+      !readDynCallGraph(NewGraph, newDCG))
+    return 1;
+
+  std::vector<ContextDiff> diffs;
+  compareGraphs(oldDCG, newDCG, diffs);
+  reportGraphs(outs(), oldDCG, newDCG, diffs);
+
+  if (OldTimeProfile.empty() != NewTimeProfile.empty()) {
+    errs() << argv[0] << ": -time-old and -time-new must be given together\n";
+    return 1;
+  }
+  if (OldTimeProfile.empty())
+    return 0;
+
+  // the module only names the functions; without it they are numbered
+  LLVMContext &context = getGlobalContext();
+  std::auto_ptr<Module> mod;
+  if (!ModuleFile.empty()) {
+    OwningPtr<MemoryBuffer> file;
+    std::string errorMessage;
+    if (error_code ec = MemoryBuffer::getFile(ModuleFile, file)) {
+      errs() << argv[0] << ": error reading '" << ModuleFile << "': "
+             << ec.message() << '\n';
+      return 1;
+    }
+    mod.reset(ParseBitcodeFile(file.get(), context, &errorMessage));
+    if (!mod.get()) {
+      errs() << argv[0] << ": bytecode didn't read correctly: "
+             << errorMessage << '\n';
+      return 1;
+    }
+  } else
+    mod.reset(new Module("parpot-diff", context));
+
+  reportTimeProfiles(outs(), argv[0], *mod);
+  return 0;
+}
@@ -0,0 +1,63 @@
+//===---------- ParPotStacks.cpp - Self-time export tool ------------------===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// The parpot-stacks tool reads a dynamic call graph and writes the self times
+// of its calling contexts in the folded-stack format of flame-graph tools.
+// Optionally, the functions with the highest self time are reported.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DynCallGraph/DynCallGraph.h"
+#include "DynCallGraph/DynCallGraphExport.h"
+#include "DynCallGraph/DynCallGraphParser.h"
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace llvm;
+
+namespace {
+  cl::opt<std::string>
+  InputGraph(cl::Positional, cl::desc("<dynamic call graph>"), cl::Required);
+
+  cl::opt<std::string>
+  OutputFile("o", cl::desc("Output file of the folded stacks (default = '-')"),
+             cl::value_desc("filename"), cl::init("-"));
+
+  cl::opt<unsigned>
+  TopN("top", cl::desc("Report the functions with the highest self time "
+                       "(0 = no report)"),
+       cl::init(0));
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
+
+  cl::ParseCommandLineOptions(argc, argv, "parpot self-time export\n");
+
+  DynCallGraph graph;
+  if (!readDynCallGraph(InputGraph, graph))
+    return 1;
+
+  std::string errorInfo;
+  OwningPtr<raw_fd_ostream> out(new raw_fd_ostream(OutputFile.c_str(),
+                                                   errorInfo));
+  if (!errorInfo.empty()) {
+    errs() << argv[0] << ": " << errorInfo << '\n';
+    return 1;
+  }
+  writeFoldedStacks(graph, *out);
+
+  // the report goes to stderr if the stacks are written to stdout
+  if (TopN)
+    printTopSelfTimes(graph, TopN, OutputFile == "-" ? errs() : outs());
+  return 0;
+}
@@ -28,12 +28,22 @@
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/PathV2.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/PassManager.h"
 
 #include "Instrumentation/Instrumentation.h"
+#include "ProfileMerge.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <cstring>
+#include <map>
 #include <memory>
+#include <sys/wait.h>
+#include <unistd.h>
 using namespace llvm;
 
 namespace {
@@ -87,8 +97,42 @@ namespace {
   NoLazyCompilation("disable-lazy-compilation",
                   cl::desc("Disable JIT lazy compilation"),
                   cl::init(false));
+
+  cl::opt<std::string>
+  CacheDir("cache-dir",
+           cl::desc("Directory of the instrumented bitcode cache "
+                    "(default = '.parpot-cache')"),
+           cl::value_desc("directory"),
+           cl::init(".parpot-cache"));
+
+  cl::opt<bool>
+  NoCache("disable-cache",
+          cl::desc("Instrument the input bitcode even if a cached result "
+                   "exists"),
+          cl::init(false));
+
+  cl::opt<std::string>
+  RunList("run-list",
+          cl::desc("Profile every set of program arguments listed in the "
+                   "given file and merge the results"),
+          cl::value_desc("filename"));
+
+  cl::opt<bool>
+  ProfileLoops("profile-loops",
+               cl::desc("Profile the time of loops along with functions"),
+               cl::init(false));
+
+  cl::opt<unsigned>
+  Jobs("j",
+       cl::desc("Number of concurrent profiling runs for -run-list "
+                "(default = 1)"),
+       cl::init(1));
 }
 
+// Version of the instrumentation passes. It is part of every cache key, so
+// bump it whenever the instrumentation changes its output.
+static const char *const InstrumentationVersion = "parpot-ins-4";
+
 static ExecutionEngine *EE = 0;
 
 static void do_shutdown() {
@@ -110,67 +154,67 @@ static inline std::string getFileNameRoot(const std::string &InputFilename) {
   return outputFilename;
 }
 
-static int insTimeProfiling(int argc, char **argv, std::string &outFile) {
-  // Load the module to be compiled...
-  std::auto_ptr<Module> mod;
-  std::string Errormessage;
+// hashBytes - Feeds a block of bytes into a 64 bit FNV-1a hash.
+static uint64_t hashBytes(const char *data, size_t len, uint64_t hash) {
+  for (size_t i = 0; i != len; ++i) {
+    hash ^= (unsigned char)data[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// getCacheFileName - Builds the cache entry name of an instrumented module. The
+// key covers the input bitcode, the instrumentation (suffix) and the version of
+// the instrumentation passes.
+static std::string getCacheFileName(const MemoryBuffer &input,
+                                    const char *suffix) {
+  uint64_t key = 14695981039346656037ULL;
+  key = hashBytes(input.getBufferStart(), input.getBufferSize(), key);
+  key = hashBytes(suffix, strlen(suffix), key);
+  key = hashBytes(InstrumentationVersion, strlen(InstrumentationVersion), key);
+
+  SmallString<128> path(CacheDir.getValue());
+  sys::path::append(path, sys::path::filename(getFileNameRoot(InputFile)));
+  return path.str().str() + "." + utohexstr(key) + suffix;
+}
 
+// instrument - Instruments the input bitcode with the pass created by
+// createPass (and createExtraPass, if given) and stores the result in outFile.
+// Unless caching is disabled, the result is kept in the cache directory and
+// reused by later runs on the same bitcode.
+static int instrument(char **argv, ModulePass *(*createPass)(),
+                      const char *suffix, std::string &outFile,
+                      ModulePass *(*createExtraPass)() = 0) {
   OwningPtr<MemoryBuffer> File;
   if (error_code ec = MemoryBuffer::getFileOrSTDIN(InputFile, File)) {
-    mod.reset(ParseBitcodeFile(File.get(), getGlobalContext(), &Errormessage));
-  }
-
-  if (mod.get() == 0) {
-    errs() << argv[0] << ": bytecode didn't read correctly.\n";
+    errs() << argv[0] << ": error reading '" << InputFile << "': "
+           << ec.message() << "\n";
     return 1;
   }
 
-  // Build up all of the passes that we want to do to the module...
-  PassManager passes;
-
-  // add instrumentation pass for function time profiling
-  passes.add(createFTimeProfilerPass());
-
-  // construct output filename
-  outFile = getFileNameRoot(InputFile);
-  outFile += ".ftime.inst";
+  // construct output filename and check for a cached result
+  if (NoCache) {
+    outFile = getFileNameRoot(InputFile) + suffix;
+  } else {
+    bool existed;
+    if (error_code ec = sys::fs::create_directories(Twine(CacheDir), existed)) {
+      errs() << argv[0] << ": error creating " << CacheDir << ": "
+             << ec.message() << "\n";
+      return 1;
+    }
 
-  // prepare output file
-  raw_fd_ostream *out = 0;
-  std::string error;
-  out = new raw_fd_ostream(outFile.c_str(), error);
-  if (error.length()) {
-    errs() << argv[0] << ": error opening " << outFile << "!\n";
-    delete out;
-    return 1;
+    outFile = getCacheFileName(*File, suffix);
+    bool cached = false;
+    if (!sys::fs::exists(Twine(outFile), cached) && cached) {
+      errs() << argv[0] << ": using cached " << outFile << "\n";
+      return 0;
+    }
   }
 
-  // make sure that the Out file gets unlinked from the disk if we get a
-  // SIGINT
-  sys::RemoveFileOnSignal(sys::Path(outFile));
-
-  // Add the writing of the output file to the list of passes
-  passes.add (createBitcodeWriterPass(*out));
-
-  // Run our queue of passes all at once now, efficiently.
-  passes.run(*mod.get());
-
-  // Delete the ostream
-  delete out;
-
-  return 0;
-}
-
-static int insDynCallGraph(int argc, char **argv, std::string &outFile) {
   // Load the module to be compiled...
   std::auto_ptr<Module> mod;
   std::string Errormessage;
-
-  OwningPtr<MemoryBuffer> File;
-  if (error_code ec = MemoryBuffer::getFileOrSTDIN(InputFile, File)) {
-    mod.reset(ParseBitcodeFile(File.get(), getGlobalContext(), &Errormessage));
-  }
-
+  mod.reset(ParseBitcodeFile(File.get(), getGlobalContext(), &Errormessage));
   if (mod.get() == 0) {
     errs() << argv[0] << ": bytecode didn't read correctly.\n";
     return 1;
@@ -179,26 +223,26 @@ static int insDynCallGraph(int argc, char **argv, std::string &outFile) {
   // Build up all of the passes that we want to do to the module...
   PassManager passes;
 
-  // add instrumentation pass for function time profiling
-  passes.add(createDynCallGraphPass());
-
-  // construct output filename
-  outFile = getFileNameRoot(InputFile);
-  outFile += ".dcg.inst";
+  // add instrumentation passes
+  passes.add(createPass());
+  if (createExtraPass)
+    passes.add(createExtraPass());
 
-  // prepare output file
+  // prepare output file; it is written under a temporary name and renamed
+  // afterwards so that concurrent runs never see a partial cache entry
+  std::string tmpFile = outFile + ".tmp." + utostr(getpid());
   raw_fd_ostream *out = 0;
   std::string error;
-  out = new raw_fd_ostream(outFile.c_str(), error);
+  out = new raw_fd_ostream(tmpFile.c_str(), error);
   if (error.length()) {
-    errs() << argv[0] << ": error opening " << outFile << "!\n";
+    errs() << argv[0] << ": error opening " << tmpFile << "!\n";
     delete out;
     return 1;
   }
 
   // make sure that the Out file gets unlinked from the disk if we get a
   // SIGINT
-  sys::RemoveFileOnSignal(sys::Path(outFile));
+  sys::RemoveFileOnSignal(sys::Path(tmpFile));
 
   // Add the writing of the output file to the list of passes
   passes.add (createBitcodeWriterPass(*out));
@@ -209,9 +253,26 @@ static int insDynCallGraph(int argc, char **argv, std::string &outFile) {
   // Delete the ostream
   delete out;
 
+  if (error_code ec = sys::fs::rename(Twine(tmpFile), Twine(outFile))) {
+    errs() << argv[0] << ": error writing " << outFile << ": "
+           << ec.message() << "\n";
+    return 1;
+  }
+
   return 0;
 }
 
+static int insTimeProfiling(int argc, char **argv, std::string &outFile) {
+  if (ProfileLoops)
+    return instrument(argv, createFTimeProfilerPass, ".ftime-loop.inst",
+                      outFile, createLTimeProfilerPass);
+  return instrument(argv, createFTimeProfilerPass, ".ftime.inst", outFile);
+}
+
+static int insDynCallGraph(int argc, char **argv, std::string &outFile) {
+  return instrument(argv, createDynCallGraphPass, ".dcg.inst", outFile);
+}
+
 int execute(std::string file, int argc, char **argv, char * const *envp) {
 
   LLVMContext &Context = getGlobalContext();
@@ -346,6 +407,99 @@ int execute(std::string file, int argc, char **argv, char * const *envp) {
   return 0;
 }
 
+// runCorpus - Profiles every run of the run list. The instrumented program is
+// executed in a child process per run and profile, with at most Jobs children
+// at a time. Afterwards the per-run profiles are merged into the default
+// profile files read by the analysis.
+static int runCorpus(int argc, char **argv, char * const *envp) {
+  std::vector<ProfileRun> runs;
+  if (!readRunList(RunList, runs))
+    return 1;
+  if (runs.empty()) {
+    errs() << argv[0] << ": no runs in " << RunList << "\n";
+    return 1;
+  }
+
+  std::string ftimeFile, dcgFile;
+  if (insTimeProfiling(argc, argv, ftimeFile) ||
+      insDynCallGraph(argc, argv, dcgFile))
+    return 1;
+
+  // every run gets its own output files; stale files of earlier runs are
+  // removed, since the time profile is appended to by the runtime and a run
+  // that fails early wouldn't overwrite them
+  for (unsigned i = 0; i != runs.size(); ++i) {
+    bool existed;
+    runs[i].timeProfile = "llvmtimeprof." + utostr(i) + ".out";
+    runs[i].callGraph = "dyncallgraph." + utostr(i) + ".dot";
+    sys::fs::remove(Twine(runs[i].timeProfile), existed);
+    sys::fs::remove(Twine(runs[i].callGraph), existed);
+  }
+
+  // job 2*i executes the time profiling of run i, job 2*i+1 the call graph
+  std::map<pid_t, unsigned> running;
+  unsigned next = 0, numJobs = 2 * runs.size(), failed = 0;
+  std::vector<bool> runFailed(runs.size(), false);
+  while (next < numJobs || !running.empty()) {
+    if (next < numJobs && running.size() < std::max(1U, (unsigned)Jobs)) {
+      const ProfileRun &run = runs[next / 2];
+      bool isDCG = next % 2;
+      pid_t pid = fork();
+      if (pid == 0) {
+        InputArgv.clear();
+        InputArgv.push_back(isDCG ? "-llvmdycg-output" : "-llvmprof-output");
+        InputArgv.push_back(isDCG ? run.callGraph : run.timeProfile);
+        InputArgv.insert(InputArgv.end(), run.args.begin(), run.args.end());
+        execute(isDCG ? dcgFile : ftimeFile, argc, argv, envp);
+        exit(1);
+      }
+      if (pid < 0) {
+        errs() << argv[0] << ": fork failed!\n";
+        return 1;
+      }
+      running[pid] = next++;
+      continue;
+    }
+
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0)
+      break;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      errs() << argv[0] << ": run " << running[pid] / 2
+             << " terminated abnormally\n";
+      runFailed[running[pid] / 2] = true;
+      ++failed;
+    }
+    running.erase(pid);
+  }
+
+  // a failed run has an incomplete profile and is left out of the merge; so
+  // is a run whose child couldn't be waited for
+  for (std::map<pid_t, unsigned>::iterator it = running.begin(),
+         e = running.end(); it != e; ++it) {
+    runFailed[it->second / 2] = true;
+    ++failed;
+  }
+  std::vector<ProfileRun> completed;
+  for (unsigned i = 0; i != runs.size(); ++i)
+    if (!runFailed[i])
+      completed.push_back(runs[i]);
+
+  if (failed)
+    errs() << argv[0] << ": " << failed << " of " << numJobs
+           << " profiling runs failed, " << runs.size() - completed.size()
+           << " of " << runs.size() << " runs are left out\n";
+  if (completed.empty())
+    return 1;
+
+  // merge the per-run profiles
+  if (!mergeTimeProfiles(completed, "llvmtimeprof.out") ||
+      !mergeDynCallGraphs(completed, "dyncallgraph.dot"))
+    return 1;
+  return 0;
+}
+
 //===----------------------------------------------------------------------===//
 // main Driver function
 //
@@ -363,6 +517,12 @@ int main(int argc, char **argv, char * const *envp) {
   cl::ParseCommandLineOptions(argc, argv, "parpot measurement tool\n");
   std::string file;
 
+  /*
+   * Profiling of a corpus of inputs
+   */
+  if (!RunList.empty())
+    return runCorpus(argc, argv, envp);
+
   /*
    * Function time profiling
    */
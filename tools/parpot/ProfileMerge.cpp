@@ -0,0 +1,116 @@
+//===----- ProfileMerge.cpp - Merging of profiling runs - Implementation --===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the merging of time profiles and dynamic call graphs of
+// several profiling runs.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ProfileMerge.h"
+#include "Analysis/TimeProfileInfoTypes.h"
+
+#include "DynCallGraph/DynCallGraphExport.h"
+#include "DynCallGraph/DynCallGraphParser.h"
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace llvm;
+
+bool llvm::readRunList(const std::string &filename,
+                       std::vector<ProfileRun> &runs) {
+  std::ifstream file(filename.c_str());
+  if (!file) {
+    errs() << "Error: Can't open file " << filename << '\n';
+    return false;
+  }
+
+  std::string line;
+  while (getline(file, line)) {
+    std::istringstream sLine(line);
+    std::string arg;
+    ProfileRun run;
+    bool first = true;
+    while (sLine >> arg) {
+      if (first && arg[0] == '#')
+        break; // comment line
+      if (first && StringRef(arg).startswith("weight="))
+        run.weight = strtod(arg.c_str() + 7, 0);
+      else
+        run.args.push_back(arg);
+      first = false;
+    }
+    if (!first)
+      runs.push_back(run);
+  }
+
+  return true;
+}
+
+bool llvm::mergeTimeProfiles(const std::vector<ProfileRun> &runs,
+                             const std::string &outFile) {
+  FILE *out = fopen(outFile.c_str(), "wb");
+  if (!out) {
+    errs() << "Error: Can't open file " << outFile << '\n';
+    return false;
+  }
+
+  char buffer[4096];
+  for (std::vector<ProfileRun>::const_iterator it = runs.begin(),
+        e = runs.end(); it != e; ++it) {
+    FILE *in = fopen(it->timeProfile.c_str(), "rb");
+    if (!in) {
+      errs() << "WARNING: no time profile for run " << it->timeProfile << '\n';
+      continue;
+    }
+
+    // the weight packet applies to all following packets of the run
+    unsigned pTy = RunWeightInfo;
+    fwrite(&pTy, sizeof(unsigned), 1, out);
+    fwrite(&it->weight, sizeof(double), 1, out);
+
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0)
+      fwrite(buffer, 1, n, out);
+    fclose(in);
+  }
+
+  fclose(out);
+  return true;
+}
+
+bool llvm::mergeDynCallGraphs(const std::vector<ProfileRun> &runs,
+                              const std::string &outFile) {
+  std::vector<std::string> files;
+  std::vector<double> weights;
+  for (std::vector<ProfileRun>::const_iterator it = runs.begin(),
+        e = runs.end(); it != e; ++it) {
+    files.push_back(it->callGraph);
+    weights.push_back(it->weight);
+  }
+
+  // the graphs are merged like several -dcg-file options, but weighted
+  DynCallGraph graph;
+  if (files.empty() || !readDynCallGraphs(files, weights, graph)) {
+    errs() << "Error: No dynamic call graph to merge\n";
+    return false;
+  }
+
+  std::string error;
+  raw_fd_ostream out(outFile.c_str(), error);
+  if (!error.empty()) {
+    errs() << "Error: Can't open file " << outFile << '\n';
+    return false;
+  }
+
+  writeDynCallGraph(graph, out);
+  return true;
+}
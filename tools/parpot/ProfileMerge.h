@@ -0,0 +1,50 @@
+//===-------- ProfileMerge.h - Merging of profiling runs - Interface -------===//
+//
+//                 ParPot - Parallelization Potential - Measurement
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the helper functions of the parpot tool that merge the
+// time profiles and dynamic call graphs of several profiling runs into one
+// aggregate profile.
+//
+//===----------------------------------------------------------------------===//
+#ifndef PARPOT_TOOLS_PROFILEMERGE_H
+#define PARPOT_TOOLS_PROFILEMERGE_H
+
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+  /// A ProfileRun describes one execution of the instrumented program: its
+  /// arguments, its weight within the aggregate profile and the files the
+  /// profiling runtimes write for it.
+  struct ProfileRun {
+    std::vector<std::string> args;
+    double weight;
+    std::string timeProfile;
+    std::string callGraph;
+
+    ProfileRun(): weight(1.0) { }
+  };
+
+  /// reads a run list. Every non-empty line that does not start with '#'
+  /// describes one run by its whitespace separated program arguments. An
+  /// optional leading "weight=<w>" token sets the weight of the run.
+  bool readRunList(const std::string &filename, std::vector<ProfileRun> &runs);
+
+  /// merges the time profiles of all runs into outFile. Each run is preceded by
+  /// a RunWeightInfo packet, so the loader weights its timings.
+  bool mergeTimeProfiles(const std::vector<ProfileRun> &runs,
+                         const std::string &outFile);
+
+  /// merges the dynamic call graphs of all runs into outFile. Equivalent
+  /// calling contexts are unified; their execution times and call counts are
+  /// summed up, weighted by the weight of the run. Each node also records the
+  /// variance of its execution time over the runs.
+  bool mergeDynCallGraphs(const std::vector<ProfileRun> &runs,
+                          const std::string &outFile);
+}
+
+#endif